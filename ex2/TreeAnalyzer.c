@@ -1,93 +1,360 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "queue.h"
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#include "TreeAnalyzer.h"
 
 #define NUM_ARGS 3
-#define WRONG_NUM_OF_ARGS_MSG "Usage: TreeAnalyzer <Graph File Path> <First Vertex> <Second Vertex>\n"
+#define WRONG_NUM_OF_ARGS_MSG "Usage: TreeAnalyzer [Options] <Graph File Path> <First Vertex> <Second Vertex>\n" \
+                              "       TreeAnalyzer [Options] --batch <Manifest Path>\n" \
+                              "Options: --format <children|edges|parents|edges-bin|parents-bin>\n" \
+                              "         --threads <1-256>  --save-cache <Path>  --load-cache\n" \
+                              "         --metrics  --canonical-hash  --profile  --succinct\n" \
+                              "         --eccentricities <Path>  --eccentricities-bin <Path>\n" \
+                              "         --weighted  --weight-queries <Script Path>  --dynamic <Script Path>\n" \
+                              "         --out-of-core <Directory>  --memory-budget <MB>\n"
+#define UNKNOWN_OPTION_MSG "Unknown option: %s\n"
+#define BAD_OPTION_VALUE_MSG "Invalid value for %s\n"
+#define CONFLICTING_OPTION_MSG "%s can't be combined with the other options given\n"
 #define INVALID_INPUT_MSG "Invalid input\n"
 #define MEMORY_ALLOCATION_FAILED "Memory allocation failed\n"
-#define MAX_LINE_LEN 1024
 #define BASE 10
-#define INPUT_DELIMS " \t\r\n"
-#define DEFAULT_PARENT -1
+#define READ_CHUNK_SIZE 65536
 #define DEFAULT_DIAMETER 0
+#define FILE_WRITE_FAILED_MSG "Failed writing to a file\n"
+#define SAVE_CACHE_OPTION "--save-cache"
+#define LOAD_CACHE_OPTION "--load-cache"
+#define THREADS_OPTION "--threads"
+#define MAX_THREADS 256
+#define PARALLEL_PARSE_MIN_BYTES (1 << 20)
+#define PARALLEL_FRONTIER_MIN 4096
+#define FRONTIER_CHUNK_LEN 256
+#define LOCAL_FRONTIER_LEN 1024
+#define ARENA_ALIGNMENT 64
+#define METRICS_OPTION "--metrics"
+#define OUT_OF_CORE_OPTION "--out-of-core"
+#define MEMORY_BUDGET_OPTION "--memory-budget"
+#define DEFAULT_MEMORY_BUDGET_MB 256
+#define DYNAMIC_OPTION "--dynamic"
+#define SCRIPT_OPEN_FAILED_MSG "Failed opening the script\n"
+#define BATCH_OPTION "--batch"
+#define FORMAT_OPTION "--format"
+#define WEIGHTED_OPTION "--weighted"
+#define WEIGHT_QUERIES_OPTION "--weight-queries"
+#define SUM_COMMAND "sum"
+#define MAX_COMMAND "max"
+#define DISTANCE_COMMAND "distance"
+#define SET_COMMAND "set"
+#define CANONICAL_HASH_OPTION "--canonical-hash"
+#define HASH_OPEN 0x6a09e667f3bcc908ULL
+#define HASH_CLOSE 0xbb67ae8584caa73bULL
+#define HASH_PAIR 0x3c6ef372fe94f82bULL
+#define HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+#define CANONICAL_HASH_FORMAT "Canonical Hash: %016llx\n"
+#define ECCENTRICITIES_OPTION "--eccentricities"
+#define BINARY_ECCENTRICITIES_OPTION "--eccentricities-bin"
+#define RADIUS_FORMAT "Radius: %d\n"
+#define SUCCINCT_OPTION "--succinct"
+#define PROFILE_OPTION "--profile"
+#define NANOS_IN_SECOND 1e9
+#define NO_COUNTER -1
+#define BITS_IN_BYTE 8
+#define MANIFEST_OPEN_FAILED_MSG "Failed opening the batch manifest\n"
+#define MANIFEST_DELIMITERS " \t\r\n"
+#define CACHE_MAGIC 0x45455254u
+#define CACHE_VERSION 2u
+#define CACHE_CHECKSUM_MOD 0xffffffffULL
+#define CACHE_BUFFER_LEN 4096
+#define CACHE_NUM_OF_NODE_ARRAYS 3
 
-enum validityType
+/**
+ * The phases of the analysis that are timed by the profile.
+ */
+enum profilePhase
         {
-    INVALID_INPUT,
-    NOT_A_TREE,
-    BAD_MEMORY_ALLOCATION,
-    VALID_INPUT
+    READ_PHASE,
+    PARSE_PHASE,
+    BRANCHES_PHASE,
+    DIAMETER_PHASE,
+    PRINT_PHASE,
+    EXTRAS_PHASE,
+    NUM_OF_PHASES
         };
 
 /**
- * structure that represents a Node in the graph. Each node has a different key,
- * each nodes has children if it has ones, and each has a parent and parent key, unless he is a root.
+ * structure that holds the measurements of a profiled run. A tree that is not profiled has no profile,
+ * and nothing is measured for it.
  */
-typedef struct Node
+typedef struct Profile
 {
-    int key;
-    int numOfChildren;
-    int parentKey;
-    int distance;
-    struct Node *previus;
-    struct Node **children;
-    struct Node *parent;
-} Node;
+    double phaseStart;
+    double phaseTimes[NUM_OF_PHASES];
+    int numOfBFS;
+    long long edgesVisited;
+    int queueHighWater;
+    size_t heapBytes;
+    int cacheMissesFd;
+} Profile;
+
+/**
+ * structure that represents the heavy light decomposition of a weighted tree. Every chain takes consecutive
+ * positions in a segment tree of the weights, sums and maxima hold the segments of position i in i + n.
+ * order holds the BFS order of the tree and downs the weight of the longest downward path of every vertex.
+ */
+typedef struct HeavyLight
+{
+    int numOfNodes;
+    int diameterIsValid;
+    long long diameter;
+    int *order;
+    int *heavy;
+    int *heads;
+    int *positions;
+    int *depths;
+    long long *sums;
+    long long *maxima;
+    long long *downs;
+} HeavyLight;
+
+/**
+ * structure that holds the state of a parallel BFS. The current level is split to chunks that are taken by
+ * the threads, each thread collects the nodes of the next level locally before copying them to nextFrontier.
+ */
+typedef struct BFSContext
+{
+    Tree *tree;
+    pthread_t *workers;
+    int numOfWorkers;
+    int *frontier;
+    int *nextFrontier;
+    int frontierSize;
+    int nextFrontierSize;
+    int nextChunk;
+    int inf;
+    int notATree;
+    int done;
+    int numOfParticipants;
+    int arrived;
+    int generation;
+    int maxQueued;
+    pthread_mutex_t lock;
+    pthread_cond_t levelDone;
+} BFSContext;
+
+/**
+ * structure that represents the header of a binary tree cache file. The header is followed by the parent
+ * array, numOfNodes + 1 children offsets, numOfEdges children and the depth of each node if hasDepth is set.
+ * The checksum covers the fields of the header before it and then all the arrays.
+ */
+typedef struct CacheHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    int numOfNodes;
+    int numOfEdges;
+    int root;
+    int minBranch;
+    int maxBranch;
+    int hasDepth;
+    unsigned long long checksum;
+} CacheHeader;
+
+#define CACHE_HEADER_FIELDS ((sizeof(CacheHeader) - sizeof(unsigned long long)) / sizeof(int))
+
+/**
+ * structure that represents a row of a batch manifest: the arguments of one analysis, in the layout of argv,
+ * and the output of the analysis, kept until the rows before it are printed.
+ */
+typedef struct BatchRow
+{
+    char *line;
+    char *argv[NUM_ARGS + 1];
+    int numOfFields;
+    char *output;
+    size_t outputLen;
+    enum validityType result;
+} BatchRow;
+
+/**
+ * structure that holds the state of a batch analysis, the workers take the rows by their order.
+ */
+typedef struct BatchContext
+{
+    enum inputFormat inputFormat;
+    int withCanonicalHash;
+    BatchRow *rows;
+    int numOfRows;
+    int nextRow;
+} BatchContext;
+
+/**
+ * Takes memory from the arena of the tree. An arena without memory only measures: it counts the bytes that
+ * would be taken and returns NULL, so the size of an arena is found by the same calls that carve it.
+ * @param arena the arena
+ * @param size the number of bytes to take
+ * @return the memory, or NULL if the arena is too small or only measures
+ */
+void *arenaAlloc(Arena *arena, size_t size)
+{
+    size_t start = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (arena->memory == NULL)
+    {
+        arena->used = start + size;
+        return NULL;
+    }
+    if (start + size > arena->capacity)
+    {
+        return NULL;
+    }
+    arena->used = start + size;
+    return arena->memory + start;
+}
 
 /**
- * A function that frees the given node.
- * @param node the Node to be freed.
+ * Carves the arrays of the tree from an arena: the nodes, the edges, the path, the disjoint sets of the
+ * parser and the traversal array, the arrays of the structural metrics, the weights with their heavy light
+ * decomposition, the subtree hashes and the arrays of the eccentricities.
+ * @param tree the tree, with its number of nodes and options set
+ * @param arena the arena
+ * @return VALID_INPUT, or BAD_MEMORY_ALLOCATION if the arena is too small or only measures
  */
-void freeNode(Node *node)
+enum validityType carveTree(Tree *tree, Arena *arena)
 {
-    if (node != NULL)
+    size_t n = (size_t)tree->numOfNodes;
+    size_t arrayLen = sizeof(int) * n;
+    int carved = 1;
+    tree->nodes = (Node *)arenaAlloc(arena, sizeof(Node) * n);
+    // a tree has exactly numOfNodes - 1 edges.
+    tree->edges = (int *)arenaAlloc(arena, arrayLen);
+    tree->path = (int *)arenaAlloc(arena, arrayLen);
+    tree->sets = (int *)arenaAlloc(arena, arrayLen);
+    tree->traversal = (int *)arenaAlloc(arena, arrayLen);
+    carved = carved && tree->nodes != NULL && tree->edges != NULL && tree->path != NULL && tree->sets != NULL &&
+             tree->traversal != NULL;
+    if (tree->withMetrics)
+    {
+        tree->subtreeSizes = (int *)arenaAlloc(arena, arrayLen);
+        tree->heights = (int *)arenaAlloc(arena, arrayLen);
+        carved = carved && tree->subtreeSizes != NULL && tree->heights != NULL;
+    }
+    if (tree->withWeights)
     {
-        if (node->children != NULL)
+        // the arrays are carved into a local copy, since a measuring arena has no decomposition to fill.
+        size_t sumsLen = 2 * sizeof(long long) * n;
+        HeavyLight layout;
+        tree->heavyLight = (HeavyLight *)arenaAlloc(arena, sizeof(HeavyLight));
+        tree->weights = (int *)arenaAlloc(arena, arrayLen);
+        layout.order = (int *)arenaAlloc(arena, arrayLen);
+        layout.heavy = (int *)arenaAlloc(arena, arrayLen);
+        layout.heads = (int *)arenaAlloc(arena, arrayLen);
+        layout.positions = (int *)arenaAlloc(arena, arrayLen);
+        layout.depths = (int *)arenaAlloc(arena, arrayLen);
+        layout.sums = (long long *)arenaAlloc(arena, sumsLen);
+        layout.maxima = (long long *)arenaAlloc(arena, sumsLen);
+        layout.downs = (long long *)arenaAlloc(arena, sumsLen / 2);
+        carved = carved && tree->heavyLight != NULL && tree->weights != NULL && layout.order != NULL &&
+                 layout.heavy != NULL && layout.heads != NULL && layout.positions != NULL &&
+                 layout.depths != NULL && layout.sums != NULL && layout.maxima != NULL && layout.downs != NULL;
+        if (carved)
         {
-            free(node->children);
+            *tree->heavyLight = layout;
+            memset(tree->weights, 0, arrayLen);
         }
     }
+    if (tree->withCanonicalHash)
+    {
+        size_t hashesLen = sizeof(unsigned long long) * n;
+        tree->subtreeHashes = (unsigned long long *)arenaAlloc(arena, hashesLen);
+        tree->hashScratch = (unsigned long long *)arenaAlloc(arena, hashesLen);
+        carved = carved && tree->subtreeHashes != NULL && tree->hashScratch != NULL;
+    }
+    if (tree->withEccentricities)
+    {
+        tree->downFirst = (int *)arenaAlloc(arena, arrayLen);
+        tree->downSecond = (int *)arenaAlloc(arena, arrayLen);
+        tree->eccentricities = (int *)arenaAlloc(arena, arrayLen);
+        carved = carved && tree->downFirst != NULL && tree->downSecond != NULL && tree->eccentricities != NULL;
+    }
+    return carved ? VALID_INPUT : BAD_MEMORY_ALLOCATION;
 }
 
+BFSContext *carveBFSContext(const Tree *tree, Arena *arena);
+
 /**
- * structure that represents a tree graph. Each Tree has a root, the nodes in the tree,
- * the number of nodes in that tree and the depth of the tree.
+ * Calculates the size of the arena of the tree, by carving its arrays and the state of the parallel BFS
+ * from an arena that only measures.
+ * @param tree the tree, with its number of nodes and options set
+ * @return the size of the arena in bytes
  */
-typedef struct Tree
+size_t arenaSize(const Tree *tree)
 {
-    int numOfEdges;
-    int numOfNodes;
-    int root;
-    int maxBranch;
-    int minBranch;
-    int diameter;
-    int pathLen;
-    int *path;
-    Node *nodes;
-} Tree;
+    Tree layout = *tree;
+    Arena counter = {NULL, 0, 0};
+    carveTree(&layout, &counter);
+    if (tree->numOfThreads > 1)
+    {
+        carveBFSContext(tree, &counter);
+    }
+    return counter.used;
+}
+
+void stopBFSWorkers(Tree *tree);
 
 /**
- * A function that frees the given node.
+ * A function that frees the given tree.
  * @param node the tree to be freed.
  */
 void freeTree(Tree *tree)
 {
     if (tree != NULL)
     {
-        if (tree->nodes != NULL)
-        {
-            for (int i = 0; i < tree->numOfNodes; i++)
-            {
-                freeNode(tree->nodes + i);
-            }
-            free(tree->nodes);
-        }
-        free(tree->path);
+        stopBFSWorkers(tree);
+        free(tree->arena.memory);
+        tree->arena.memory = NULL;
+        tree->nodes = NULL;
+        tree->edges = NULL;
+        tree->sets = NULL;
+        tree->path = NULL;
+        tree->traversal = NULL;
+        tree->subtreeSizes = NULL;
+        tree->heights = NULL;
+        tree->weights = NULL;
+        tree->heavyLight = NULL;
+        tree->subtreeHashes = NULL;
+        tree->hashScratch = NULL;
+        tree->downFirst = NULL;
+        tree->downSecond = NULL;
+        tree->eccentricities = NULL;
     }
 }
 
+void initiateTree(Tree *tree);
+
+/**
+ * Prepares a tree for the analysis of another graph, keeping its arena so it is allocated only when a
+ * larger graph comes.
+ * @param tree the tree to reuse
+ */
+void reuseTree(Tree *tree)
+{
+    Arena arena = tree->arena;
+    stopBFSWorkers(tree);
+    initiateTree(tree);
+    tree->arena = arena;
+    tree->arena.used = 0;
+}
+
 /**
  * a function that initializes the given tree with its default values.
  * @param tree the tree to initiate.
@@ -101,8 +368,35 @@ void initiateTree(Tree *tree)
     tree->diameter = 0;
     tree->maxBranch = 0;
     tree->root = 0;
+    tree->numOfThreads = 1;
+    tree->withMetrics = 0;
+    tree->inputFormat = CHILD_LIST_FORMAT;
+    tree->withWeights = 0;
+    tree->withCanonicalHash = 0;
+    tree->withEccentricities = 0;
+    tree->radius = 0;
+    tree->numOfCentroids = 0;
+    tree->numOfCenters = 0;
+    tree->childrenKeysSum = 0;
     tree->path = NULL;
+    tree->edges = NULL;
+    tree->sets = NULL;
+    tree->traversal = NULL;
+    tree->subtreeSizes = NULL;
+    tree->heights = NULL;
+    tree->weights = NULL;
+    tree->heavyLight = NULL;
+    tree->subtreeHashes = NULL;
+    tree->hashScratch = NULL;
+    tree->downFirst = NULL;
+    tree->downSecond = NULL;
+    tree->eccentricities = NULL;
+    tree->profile = NULL;
+    tree->bfs = NULL;
     tree->nodes = NULL;
+    tree->arena.memory = NULL;
+    tree->arena.capacity = 0;
+    tree->arena.used = 0;
 }
 
 /**
@@ -127,12 +421,12 @@ int newNode(Node *newNode)
 
 /**
  * the known BFS function, used to find the longest path in the tree, also to varify if it
- * is a tree.
+ * is a tree. Runs on the calling thread only.
  * @param tree the graph in which the search is done.
  * @param s the node from which the search begin.
  * @return 0 if the graph is a tree and 1 if it's not.
  */
-int BFS(Tree *tree, Node *s)
+int serialBFS(Tree *tree, Node *s)
 {
     int inf = tree->numOfNodes + 1;
     Node *curNode;
@@ -144,21 +438,25 @@ int BFS(Tree *tree, Node *s)
     }
     s->previus = NULL;
     s->distance = 0;
-    Queue * Q = allocQueue();
-    enqueue(Q, (unsigned int)s->key);
-    while (!queueIsEmpty(Q))
+    // every node is queued once, so the queue never wraps around the traversal array.
+    int *queue = tree->traversal;
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = s->key;
+    while (head != tail)
     {
-        curNodeKey = (int)dequeue(Q);
+        curNodeKey = queue[head++];
         curNode = &tree->nodes[curNodeKey];
         for (int j = 0; j < (curNode->numOfChildren); ++j)
         {
-            if (curNode->previus == NULL || curNode->previus != curNode->children[j])
+            Node *child = &tree->nodes[curNode->children[j]];
+            if (curNode->previus == NULL || curNode->previus != child)
             {
-                if (curNode->children[j]->distance == inf)
+                if (child->distance == inf)
                 {
-                    enqueue(Q, (unsigned int)curNode->children[j]->key);
-                    curNode->children[j]->previus = curNode;
-                    curNode->children[j]->distance = curNode->distance + 1;
+                    queue[tail++] = child->key;
+                    child->previus = curNode;
+                    child->distance = curNode->distance + 1;
                 }
                 else
                 {
@@ -169,432 +467,2828 @@ int BFS(Tree *tree, Node *s)
         if (curNode->parentKey != DEFAULT_PARENT &&
             (curNode->previus == NULL || curNode->previus->key != curNode->parentKey))
         {
-            enqueue(Q, (unsigned int)curNode->parentKey);
+            queue[tail++] = curNode->parentKey;
             curNode->parent->previus = curNode;
             curNode->parent->distance = curNode->distance + 1;
         }
     }
-    freeQueue(&Q);
     return EXIT_SUCCESS;
 }
 
 /**
- * a function creating a tree, while creating its nodes according to the input, and set
- * his node's keys.
- * @param treeNumOfNodes the number of the nodes in the tree.
- * @return the created tree from the function.
+ * Claims the given node for the next level of a parallel BFS. The visited marking is atomic, so a node is
+ * claimed by one thread only.
+ * @param context the BFS that is running
+ * @param curNode the node of the current level
+ * @param next the node to claim
+ * @param localFrontier the nodes that were claimed by this thread and not flushed yet
+ * @param localSize the number of nodes in localFrontier
  */
-enum validityType newTree(int treeNumOfNodes, Tree* myTree)
+static void claimNode(BFSContext *context, Node *curNode, Node *next, int *localFrontier, int *localSize)
 {
-    if (myTree != NULL)
+    int expected = context->inf;
+    if (!__atomic_compare_exchange_n(&next->distance, &expected, curNode->distance + 1, 0,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
     {
-        myTree->numOfNodes = treeNumOfNodes;
-        myTree->numOfEdges = 0;
-        myTree->diameter = DEFAULT_DIAMETER;
-        myTree->path = (int*)malloc(sizeof(int) * treeNumOfNodes);
-        myTree->nodes = (Node *) malloc(treeNumOfNodes * sizeof(Node));
-        if (myTree->nodes != NULL)
-        {
-            for (int i = 0; i < treeNumOfNodes; i++)
-            {
-                if (newNode(&myTree->nodes[i]) == EXIT_FAILURE)
-                {
-                    return BAD_MEMORY_ALLOCATION;
-                }
-                if (&(myTree->nodes[i]) == NULL)
-                {
-                    freeTree(myTree);
-                    return BAD_MEMORY_ALLOCATION;
-                }
-                myTree->nodes[i].key = i;
-            }
-        }
-        else
-        {
-            // creating tree without spaces.
-            return BAD_MEMORY_ALLOCATION;
-        }
+        __atomic_store_n(&context->notATree, 1, __ATOMIC_RELAXED);  //since the node was visited already
+        return;
     }
-    else
+    next->previus = curNode;
+    if (*localSize == LOCAL_FRONTIER_LEN)
     {
-        return BAD_MEMORY_ALLOCATION;
+        int offset = __atomic_fetch_add(&context->nextFrontierSize, *localSize, __ATOMIC_RELAXED);
+        memcpy(context->nextFrontier + offset, localFrontier, sizeof(int) * (size_t)*localSize);
+        *localSize = 0;
     }
-    return VALID_INPUT;
+    localFrontier[(*localSize)++] = next->key;
 }
 
 /**
- * a function to calculate and update the tree according to the longest branches.
- * @param tree the tree to calculate the branches in.
- * @param minBranch the minimum branch in the tree
- * @param maxBranch the maximum branch in the tree
+ * Expands chunks of the current level of a parallel BFS into the next level, until no chunk is left.
+ * Called by every thread that takes part in the level.
+ * @param context the BFS that is running
  */
-void minMaxBranch(Tree *tree, int *minBranch, int *maxBranch)
+static void expandFrontier(BFSContext *context)
 {
-    for (int i = 0; i< tree->numOfNodes; ++i)
+    int localFrontier[LOCAL_FRONTIER_LEN];
+    int localSize = 0;
+    Tree *tree = context->tree;
+    int start;
+    while ((start = __atomic_fetch_add(&context->nextChunk, FRONTIER_CHUNK_LEN, __ATOMIC_RELAXED))
+           < context->frontierSize)
     {
-        if (tree->nodes[i].distance > *maxBranch)
-        {
-            *maxBranch = tree->nodes[i].distance;
-        }
-        if (tree->nodes[i].numOfChildren == 0)
+        int end = (start + FRONTIER_CHUNK_LEN < context->frontierSize) ? start + FRONTIER_CHUNK_LEN
+                                                                        : context->frontierSize;
+        for (int i = start; i < end; ++i)
         {
-            if (tree->nodes[i].distance < *minBranch)
+            Node *curNode = &tree->nodes[context->frontier[i]];
+            for (int j = 0; j < curNode->numOfChildren; ++j)
             {
-                *minBranch = tree->nodes[i].distance;
+                Node *child = &tree->nodes[curNode->children[j]];
+                if (curNode->previus == NULL || curNode->previus != child)
+                {
+                    claimNode(context, curNode, child, localFrontier, &localSize);
+                }
+            }
+            if (curNode->parentKey != DEFAULT_PARENT &&
+                (curNode->previus == NULL || curNode->previus->key != curNode->parentKey))
+            {
+                claimNode(context, curNode, curNode->parent, localFrontier, &localSize);
             }
         }
     }
+    int offset = __atomic_fetch_add(&context->nextFrontierSize, localSize, __ATOMIC_RELAXED);
+    memcpy(context->nextFrontier + offset, localFrontier, sizeof(int) * (size_t)localSize);
 }
 
-
 /**
- * a function checking if the given graph is a tree or not ( checking if it is a connected graph
- * without any circles)
- * @param tree the graph
- * @return VALID_INPUT enum if the graph is a tree and NOT_A_TREE enum if it is not
+ * Waits until every thread that takes part in the BFS reached the barrier.
+ * @param context the BFS that is running
  */
-enum validityType isTheGraphTree(Tree *tree)
+static void levelBarrier(BFSContext *context)
 {
-    int minBranch = (tree->numOfNodes + 1);
-    int maxBranch = 0;
-    if (tree->numOfEdges != (tree->numOfNodes - 1))
-    {
-        return NOT_A_TREE;
-    }
-    if (BFS(tree, &tree->nodes[tree->root]) == EXIT_FAILURE)
+    pthread_mutex_lock(&context->lock);
+    int generation = context->generation;
+    if (++context->arrived == context->numOfParticipants)
     {
-        return NOT_A_TREE;
+        context->arrived = 0;
+        context->generation++;
+        pthread_cond_broadcast(&context->levelDone);
     }
-    for (int i = 0; i < tree->numOfNodes; ++i)
+    else
     {
-        if (tree->nodes[i].distance >= tree->numOfNodes)
+        while (generation == context->generation)
         {
-            return NOT_A_TREE;
+            pthread_cond_wait(&context->levelDone, &context->lock);
         }
     }
-    minMaxBranch(tree, &minBranch, &maxBranch);
-    tree->maxBranch = maxBranch;
-    tree->minBranch = minBranch;
-    return VALID_INPUT;
+    pthread_mutex_unlock(&context->lock);
 }
 
 /**
- * Calculates the diameter of the tree and creates the path between u and v in the tree
- * @param tree the tree in which the path and the diameter and the path are calculated
- * @param uKey the first vertex
- * @param vKey the second vertex
+ * The loop of a worker thread of a parallel BFS, takes part in every wide level until the BFS is done.
+ * @param arg the BFS that is running
+ * @return NULL
  */
-void diameterAndPath(Tree *tree, Node *uKey, Node *vKey)
+static void *bfsWorker(void *arg)
 {
-    int maxBranch = 0;
-    int minBranch = 0;
-    for (int i = 0; i < tree->numOfNodes; ++i)
+    BFSContext *context = (BFSContext *)arg;
+    while (1)
     {
-        // finding the maximum branch using BFS.
-        BFS(tree, &tree->nodes[i]);
-        minMaxBranch(tree, &minBranch, &maxBranch);
-        if (tree->nodes[i].key == uKey->key)
+        levelBarrier(context);
+        if (context->done)
         {
-            tree->pathLen = 0;
-            int curNodeKey = vKey->key;
-            while (curNodeKey != uKey->key)
-            {
-                tree->path[tree->pathLen] = curNodeKey;
-                curNodeKey = tree->nodes[curNodeKey].previus->key;
-                (tree->pathLen)++;
-            }
-            tree->path[tree->pathLen] = uKey->key;
-            (tree->pathLen)++;
+            return NULL;
         }
+        expandFrontier(context);
+        levelBarrier(context);
     }
-    tree->diameter = maxBranch;
 }
 
 /**
- * Process the number as a char and turns it to an integer
- * @param value the representation of the number as a string
- * @param length the length of the number
- * @param nPointer holds the number
- * @return VALID_INPUT enum if the number was processed and INVALID_INPUT enum if the given value is not an integer.
+ * Carves the state of the parallel BFS of the tree from an arena.
+ * @param tree the tree
+ * @param arena the arena
+ * @return the state, or NULL if the arena is too small or only measures
  */
-enum validityType processN(const char *value, int length, int *nPointer)
+BFSContext *carveBFSContext(const Tree *tree, Arena *arena)
 {
-    if (length > 1 && value[0] == '0')
+    BFSContext *context = (BFSContext *)arenaAlloc(arena, sizeof(BFSContext));
+    pthread_t *workers = (pthread_t *)arenaAlloc(arena, sizeof(pthread_t) * (size_t)tree->numOfThreads);
+    int *nextFrontier = (int *)arenaAlloc(arena, sizeof(int) * (size_t)tree->numOfNodes);
+    if (context == NULL || workers == NULL || nextFrontier == NULL)
     {
-        return INVALID_INPUT;
+        return NULL;
     }
-    for (int i = 0; i < length; i++)
+    context->workers = workers;
+    context->nextFrontier = nextFrontier;
+    return context;
+}
+
+/**
+ * Starts the worker threads of the parallel BFS of the tree. The workers live as long as the tree, and wait
+ * between the levels and between the searches. Everything they share is taken from the arena of the tree.
+ * @param tree the tree
+ * @return the state of the parallel BFS, or NULL if it could not be taken from the arena
+ */
+BFSContext *startBFSWorkers(Tree *tree)
+{
+    BFSContext *context = carveBFSContext(tree, &tree->arena);
+    if (context == NULL)
     {
-        if ((value[i] < '0') || (value[i] > '9'))
-        {
-            return INVALID_INPUT;
-        }
+        return NULL;
     }
-    * nPointer = (int)strtol(value, NULL , BASE);
-    return VALID_INPUT;
+    context->tree = tree;
+    context->done = 0;
+    context->arrived = 0;
+    context->generation = 0;
+    context->numOfParticipants = tree->numOfThreads;
+    pthread_mutex_init(&context->lock, NULL);
+    pthread_cond_init(&context->levelDone, NULL);
+    context->numOfWorkers = 0;
+    while (context->numOfWorkers < tree->numOfThreads - 1 &&
+           pthread_create(&context->workers[context->numOfWorkers], NULL, bfsWorker, context) == 0)
+    {
+        context->numOfWorkers++;
+    }
+    // if not all the threads could be created, the levels are shared by the ones that were.
+    pthread_mutex_lock(&context->lock);
+    context->numOfParticipants = context->numOfWorkers + 1;
+    pthread_mutex_unlock(&context->lock);
+    tree->bfs = context;
+    return context;
 }
 
 /**
- * Count the number of children of each node
- * @param line the line in which the children are written
- * @param numOfChildren holds the number of children
- * @param length the length of the line
+ * Stops the worker threads of the parallel BFS of the tree, if they were started.
+ * @param tree the tree
  */
-void childrenCounter(const char *line, int *numOfChildren, int length)
+void stopBFSWorkers(Tree *tree)
 {
-    for (int i = 0; i < length; ++i)
+    BFSContext *context = tree->bfs;
+    if (context == NULL)
     {
-        if (line != NULL && line[i] != ' ' && line[i] != '\n')
-        {
-            (*numOfChildren)++;
-            while(line[i] != ' ' && line[i] != '\n' && i < length)
-            {
-                i++;
-            }
-        }
+        return;
     }
+    context->done = 1;
+    if (context->numOfWorkers > 0)
+    {
+        levelBarrier(context);
+    }
+    for (int i = 0; i < context->numOfWorkers; ++i)
+    {
+        pthread_join(context->workers[i], NULL);
+    }
+    pthread_mutex_destroy(&context->lock);
+    pthread_cond_destroy(&context->levelDone);
+    tree->bfs = NULL;
 }
 
 /**
- * Exits the program - prints the relevant message and  frees the tree
- * @param problem the current problem
- * @param tree the tree
- * @return 1 if there is a problem and 0 if not
+ * A level synchronous BFS that expands wide levels on tree->numOfThreads threads. Narrow levels are expanded
+ * by the calling thread alone. The distances and the previus nodes are the same as the ones of serialBFS.
+ * @param tree the graph in which the search is done.
+ * @param s the node from which the search begin.
+ * @return 0 if the graph is a tree and 1 if it's not.
  */
-int exitPro(enum validityType problem, Tree *tree)
+int parallelBFS(Tree *tree, Node *s)
 {
-    if (problem != VALID_INPUT)
+    BFSContext *context = (tree->bfs != NULL) ? tree->bfs : startBFSWorkers(tree);
+    if (context == NULL)
+    {
+        // without its state the search runs on the calling thread alone, with the same result.
+        return serialBFS(tree, s);
+    }
+    int *nextFrontier = context->nextFrontier;
+    context->frontier = tree->traversal;
+    context->inf = tree->numOfNodes + 1;
+    context->notATree = 0;
+    for (int i = 0; i < tree->numOfNodes; ++i)
     {
-        if ((problem == INVALID_INPUT) || (problem == NOT_A_TREE))
+        tree->nodes[i].distance = context->inf;
+    }
+    s->previus = NULL;
+    s->distance = 0;
+    context->frontier[0] = s->key;
+    context->frontierSize = 1;
+    context->maxQueued = 1;
+    while (context->frontierSize > 0 && !context->notATree)
+    {
+        context->nextFrontierSize = 0;
+        context->nextChunk = 0;
+        if (context->numOfWorkers == 0 || context->frontierSize < PARALLEL_FRONTIER_MIN)
         {
-            fprintf(stderr, INVALID_INPUT_MSG);
+            expandFrontier(context);
         }
-        else if (problem == BAD_MEMORY_ALLOCATION)
+        else
         {
-            fprintf(stderr, MEMORY_ALLOCATION_FAILED);
+            levelBarrier(context);
+            expandFrontier(context);
+            levelBarrier(context);
         }
-        freeTree(tree);
-        return EXIT_FAILURE;
+        // both frontiers together are the queue of the parallel BFS.
+        if (context->frontierSize + context->nextFrontierSize > context->maxQueued)
+        {
+            context->maxQueued = context->frontierSize + context->nextFrontierSize;
+        }
+        int *temp = context->frontier;
+        context->frontier = context->nextFrontier;
+        context->nextFrontier = temp;
+        context->frontierSize = context->nextFrontierSize;
     }
-    return EXIT_SUCCESS;
+    context->nextFrontier = nextFrontier;
+    return context->notATree ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
+/**
+ * Returns the time of a monotonic clock.
+ * @return the time in seconds
+ */
+static double profileNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / NANOS_IN_SECOND;
+}
 
 /**
- * Process each line in the file - counts the number of the children of each node and initializes the tree accordingly
- * @param curNode the node that the given line describes it's children
- * @param line the line that is processed, describes the children of the given node
- * @param numOfNodes the number of nodes in the given tree
- * @param treeP pointer to the tree
- * @return INVALID_INPUT enum if the line is not valid, NOT_A_TREE enum if the line
- * is valid but does not describe a tree and VALID_INPUT enum if it is ok
+ * Starts the profile of a run: the clock of the first phase, and the cache misses counter if the hardware
+ * and the kernel let the process count them.
+ * @param profile the profile
+ */
+void startProfile(Profile *profile)
+{
+    memset(profile, 0, sizeof(Profile));
+    profile->cacheMissesFd = NO_COUNTER;
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.inherit = 1;
+    profile->cacheMissesFd = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+    profile->phaseStart = profileNow();
+}
+
+/**
+ * Ends a phase of the analysis, the time since the end of the previous phase is added to it.
+ * @param profile the profile, NULL if the run is not profiled
+ * @param phase the phase that ended
  */
-enum validityType processLine(Node *curNode, char *line, const int *numOfNodes, Tree *treeP)
+void profilePhase(Profile *profile, enum profilePhase phase)
 {
-    char *value = NULL;
-    int length = (int)strlen(line);
-    if (line != NULL && line[0] == '-')
+    if (profile != NULL)
     {
-        if ((length == 0) || ((length > 1 && line[1] != '\n') && (length > 1 && line[1] != '\r')))
-        {
-            return INVALID_INPUT;
-        }
-        else
-        {
-            curNode->children = NULL;
-            curNode->numOfChildren = 0;
-            return VALID_INPUT;
-        }
+        double now = profileNow();
+        profile->phaseTimes[phase] += now - profile->phaseStart;
+        profile->phaseStart = now;
     }
-    int numOfChildren = 0;
-    enum validityType isAtree = VALID_INPUT;
-    childrenCounter(line, &numOfChildren, length);
-    if (numOfChildren == 0)
+}
+
+/**
+ * Counts memory that was taken for the tree outside of its arena, if the tree is profiled.
+ * @param tree the tree
+ * @param bytes the number of bytes that were taken
+ */
+void profileHeap(Tree *tree, size_t bytes)
+{
+    if (tree->profile != NULL)
     {
-        return INVALID_INPUT;
+        tree->profile->heapBytes += bytes;
     }
-    treeP->numOfEdges += numOfChildren;
-    if (numOfChildren > *numOfNodes)
+}
+
+/**
+ * Counts a BFS that ended: the edges it went through and the most nodes its queue held at once. The serial
+ * queue is replayed from the order the BFS left in the traversal array, so the BFS itself is not slowed down.
+ * @param tree the profiled tree, right after the BFS
+ */
+void profileBFS(Tree *tree)
+{
+    Profile *profile = tree->profile;
+    int reached = 0;
+    int highWater = 1;
+    for (int i = 0; i < tree->numOfNodes; ++i)
     {
-        isAtree = NOT_A_TREE;
+        reached += tree->nodes[i].distance <= tree->numOfNodes;
     }
-    curNode->numOfChildren = numOfChildren;
-    curNode->children = (Node**)malloc(numOfChildren * sizeof(Node));
-    if (curNode->children != NULL)
+    if (tree->numOfThreads > 1)
     {
-        value = strtok(line, INPUT_DELIMS);
-        int i = 0;
-        while (value != NULL)
-        {
-            int sonKey;
-            int precessResult = processN(value, (int)strlen(value), &sonKey);
-            if (precessResult == INVALID_INPUT || sonKey >= *numOfNodes)
-            {
-                return INVALID_INPUT;
-            }
-            curNode->children[i] = &treeP->nodes[sonKey];
-            // if the node is already visited
-            if (curNode->children[i]->parentKey != DEFAULT_PARENT)
-            {
-                isAtree = NOT_A_TREE;
-            }
-            curNode->children[i]->parentKey = curNode->key;
-            curNode->children[i]->parent = curNode;
-            i++;
-            value = strtok(NULL, INPUT_DELIMS);
-        }
-        if (isAtree == NOT_A_TREE)
-        {
-            return NOT_A_TREE;
-        }
+        highWater = tree->bfs->maxQueued;
     }
     else
     {
-        return BAD_MEMORY_ALLOCATION;
+        long long tail = 1;
+        for (int i = 0; i < reached; ++i)
+        {
+            Node *curNode = &tree->nodes[tree->traversal[i]];
+            highWater = (tail - i > highWater) ? (int)(tail - i) : highWater;
+            tail += curNode->numOfChildren + (curNode->parentKey != DEFAULT_PARENT) - (i > 0);
+        }
     }
-    return VALID_INPUT;
+    profile->numOfBFS++;
+    profile->edgesVisited += reached - 1;
+    profile->queueHighWater = (highWater > profile->queueHighWater) ? highWater : profile->queueHighWater;
 }
 
 /**
- * Checks if the given input is a valid input, checking each line is valid, and checks if the number of vertices
- * is valid comparing the given input.
- * @param argv the arguments that are given to the program
- * @param nPointer A pointer to the number of vertices in the graph - the first line in the file
- * @param uPointer A pointer to the second argument that is given as an input - the first of the vertices
- * @param vPointer A pointer to the third argument that is given as an input - the second of the vertices
- * @param treeP A pointer to the tree
- * @param fileP the file that is given as the first argument
- * @return INVALID INPUT enum if the file is not valid or one of the lines in the file is not valid,
- * NOT_A_TREE enum if the given file does not describe a tree, BAD_MEMORY_ALLOCATION enum
- * if there is no memory allocation and VALID_INPUT enum if the file was processed successfully
+ * Prints the profile of the run to the standard error and closes the cache misses counter.
+ * @param profile the profile
  */
-enum validityType inputValidityCheck(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP, FILE *fileP)
+void profilePrinter(Profile *profile)
 {
-    enum validityType isAtree = VALID_INPUT;
-    char *value = NULL;
-    if (fileP == NULL)
+    const char *phaseNames[NUM_OF_PHASES] = {"Reading", "Parsing and validation", "Branch lengths",
+                                             "Diameter and path", "Printing", "Extra analyses"};
+    struct rusage usage;
+    long long cacheMisses;
+    for (int phase = 0; phase < NUM_OF_PHASES; ++phase)
     {
-        return INVALID_INPUT;
+        fprintf(stderr, "%s Time: %.6f s\n", phaseNames[phase], profile->phaseTimes[phase]);
     }
-    int count_lines = 0;
-    char currentLine[MAX_LINE_LEN];
-    if (fgets(currentLine, MAX_LINE_LEN, fileP) == NULL)  //can't open the file
+    fprintf(stderr, "BFS Runs: %d\n", profile->numOfBFS);
+    fprintf(stderr, "Edges Visited: %lld\n", profile->edgesVisited);
+    fprintf(stderr, "Queue High-Water Mark: %d\n", profile->queueHighWater);
+    fprintf(stderr, "Heap Bytes: %zu\n", profile->heapBytes);
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
     {
-        return INVALID_INPUT;
+        fprintf(stderr, "Peak RSS: %ld KB\n", usage.ru_maxrss);
     }
-    count_lines++;
-    value = strtok(currentLine, INPUT_DELIMS);
-    if (value == NULL || strtok(NULL, INPUT_DELIMS) != NULL) //no numbers in the first line or more than one number
+    if (profile->cacheMissesFd != NO_COUNTER &&
+        read(profile->cacheMissesFd, &cacheMisses, sizeof(cacheMisses)) == (ssize_t)sizeof(cacheMisses))
     {
-        return INVALID_INPUT;
+        fprintf(stderr, "Cache Misses: %lld\n", cacheMisses);
     }
-    int length = (int)strlen(value);
-    if (length == 0 || processN(currentLine, length, nPointer) == INVALID_INPUT ||
-        processN(argv[2], (int)strlen(argv[2]), uPointer) == INVALID_INPUT ||
-        processN(argv[3], (int)strlen(argv[3]), vPointer) == INVALID_INPUT ||
-        *uPointer >= *nPointer || *vPointer >= *nPointer)
+    else
     {
-        return INVALID_INPUT;
+        fprintf(stderr, "Cache Misses: unavailable\n");
     }
-    if (newTree(*nPointer, treeP) == BAD_MEMORY_ALLOCATION)
+    if (profile->cacheMissesFd != NO_COUNTER)
+    {
+        close(profile->cacheMissesFd);
+    }
+}
+
+/**
+ * the known BFS function, used to find the longest path in the tree, also to varify if it
+ * is a tree. Runs in parallel when the tree was given more than one thread.
+ * @param tree the graph in which the search is done.
+ * @param s the node from which the search begin.
+ * @return 0 if the graph is a tree and 1 if it's not.
+ */
+int BFS(Tree *tree, Node *s)
+{
+    int result = (tree->numOfThreads > 1) ? parallelBFS(tree, s) : serialBFS(tree, s);
+    if (tree->profile != NULL)
+    {
+        profileBFS(tree);
+    }
+    return result;
+}
+
+/**
+ * a function creating a tree, while creating its nodes according to the input, and set
+ * his node's keys.
+ * @param treeNumOfNodes the number of the nodes in the tree.
+ * @return the created tree from the function.
+ */
+enum validityType newTree(int treeNumOfNodes, Tree* myTree)
+{
+    if (myTree != NULL)
+    {
+        myTree->numOfNodes = treeNumOfNodes;
+        myTree->numOfEdges = 0;
+        myTree->diameter = DEFAULT_DIAMETER;
+        size_t capacity = arenaSize(myTree);
+        myTree->arena.used = 0;
+        // a reused tree keeps its arena when it is large enough.
+        if (myTree->arena.memory == NULL || myTree->arena.capacity < capacity)
+        {
+            free(myTree->arena.memory);
+            myTree->arena.capacity = capacity;
+            myTree->arena.memory = (char *)malloc(capacity);
+            if (myTree->arena.memory == NULL)
+            {
+                myTree->arena.capacity = 0;
+                return BAD_MEMORY_ALLOCATION;
+            }
+            if (myTree->profile != NULL)
+            {
+                myTree->profile->heapBytes += capacity;
+            }
+        }
+        if (carveTree(myTree, &myTree->arena) != VALID_INPUT)
+        {
+            return BAD_MEMORY_ALLOCATION;
+        }
+        for (int i = 0; i < treeNumOfNodes; i++)
+        {
+            if (newNode(&myTree->nodes[i]) == EXIT_FAILURE)
+            {
+                return BAD_MEMORY_ALLOCATION;
+            }
+            myTree->nodes[i].key = i;
+        }
+    }
+    else
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * a function to calculate and update the tree according to the longest branches.
+ * @param tree the tree to calculate the branches in.
+ * @param minBranch the minimum branch in the tree
+ * @param maxBranch the maximum branch in the tree
+ */
+void minMaxBranch(Tree *tree, int *minBranch, int *maxBranch)
+{
+    for (int i = 0; i< tree->numOfNodes; ++i)
+    {
+        if (tree->nodes[i].distance > *maxBranch)
+        {
+            *maxBranch = tree->nodes[i].distance;
+        }
+        if (tree->nodes[i].numOfChildren == 0)
+        {
+            if (tree->nodes[i].distance < *minBranch)
+            {
+                *minBranch = tree->nodes[i].distance;
+            }
+        }
+    }
+}
+
+
+/**
+ * a function calculating the lengths of the branches of the tree, the graph was already checked to be a tree
+ * while it was parsed. Leaves the depth of each node in its distance.
+ * @param tree the tree
+ */
+void branchLengths(Tree *tree)
+{
+    int minBranch = (tree->numOfNodes + 1);
+    int maxBranch = 0;
+    BFS(tree, &tree->nodes[tree->root]);
+    minMaxBranch(tree, &minBranch, &maxBranch);
+    tree->maxBranch = maxBranch;
+    tree->minBranch = minBranch;
+}
+
+/**
+ * Calculates the diameter of the tree and creates the path between u and v in the tree. Has to be called
+ * while the distances of the nodes are their depths: the path goes up from u and v to their lowest common
+ * ancestor, and the deepest node is an end of a longest path, so the diameter is the longest branch of a
+ * BFS from that node.
+ * @param tree the tree in which the path and the diameter and the path are calculated
+ * @param uKey the first vertex
+ * @param vKey the second vertex
+ */
+void diameterAndPath(Tree *tree, Node *uKey, Node *vKey)
+{
+    int maxBranch = 0;
+    int minBranch = 0;
+    int farthest = tree->root;
+    Node *uAncestor = uKey;
+    Node *vAncestor = vKey;
+    while (uAncestor->distance > vAncestor->distance)
+    {
+        uAncestor = uAncestor->parent;
+    }
+    while (vAncestor->distance > uAncestor->distance)
+    {
+        vAncestor = vAncestor->parent;
+    }
+    while (uAncestor != vAncestor)
+    {
+        uAncestor = uAncestor->parent;
+        vAncestor = vAncestor->parent;
+    }
+    // the path is printed from its end, v is first in it and u is last.
+    int vSideLen = vKey->distance - vAncestor->distance;
+    tree->pathLen = vSideLen + (uKey->distance - uAncestor->distance) + 1;
+    int i = 0;
+    for (Node *curNode = vKey; curNode != vAncestor; curNode = curNode->parent)
+    {
+        tree->path[i++] = curNode->key;
+    }
+    tree->path[vSideLen] = vAncestor->key;
+    i = tree->pathLen - 1;
+    for (Node *curNode = uKey; curNode != uAncestor; curNode = curNode->parent)
+    {
+        tree->path[i--] = curNode->key;
+    }
+    for (i = 0; i < tree->numOfNodes; ++i)
+    {
+        if (tree->nodes[i].distance > tree->nodes[farthest].distance)
+        {
+            farthest = i;
+        }
+    }
+    // finding the maximum branch using BFS.
+    BFS(tree, &tree->nodes[farthest]);
+    minMaxBranch(tree, &minBranch, &maxBranch);
+    tree->diameter = maxBranch;
+}
+
+/**
+ * Finds the center (or the two centers) of the tree, the middle of a longest path. Has to be called right
+ * after diameterAndPath, while the previus nodes lead back to the end of the diameter the last BFS began at.
+ * @param tree the tree
+ */
+void treeCenters(Tree *tree)
+{
+    int farthest = 0;
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        if (tree->nodes[i].distance > tree->nodes[farthest].distance)
+        {
+            farthest = i;
+        }
+    }
+    Node *curNode = &tree->nodes[farthest];
+    for (int i = 0; i < tree->diameter / 2; ++i)
+    {
+        curNode = curNode->previus;
+    }
+    tree->centers[0] = curNode->key;
+    tree->numOfCenters = 1;
+    if (tree->diameter % 2 == 1)
+    {
+        tree->centers[tree->numOfCenters++] = curNode->previus->key;
+    }
+}
+
+/**
+ * Calculates the size and the height of the subtree of every node and finds the centroids of the tree, in
+ * one post order pass. The pass is iterative, the traversal array is the stack and the distance of a node
+ * holds the index of its next child while it is on the stack.
+ * @param tree the tree
+ */
+void structuralMetrics(Tree *tree)
+{
+    int *stack = tree->traversal;
+    int top = 0;
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        tree->nodes[i].distance = 0;
+        tree->subtreeSizes[i] = 1;
+        tree->heights[i] = 0;
+    }
+    tree->numOfCentroids = 0;
+    stack[top++] = tree->root;
+    while (top > 0)
+    {
+        Node *curNode = &tree->nodes[stack[top - 1]];
+        if (curNode->distance < curNode->numOfChildren)
+        {
+            stack[top++] = curNode->children[curNode->distance++];
+            continue;
+        }
+        top--;
+        // all the children are done, so the size of the subtree of the node is known.
+        int key = curNode->key;
+        int largestPart = tree->numOfNodes - tree->subtreeSizes[key];
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            if (tree->subtreeSizes[curNode->children[j]] > largestPart)
+            {
+                largestPart = tree->subtreeSizes[curNode->children[j]];
+            }
+        }
+        if (2 * largestPart <= tree->numOfNodes && tree->numOfCentroids < MAX_CENTERS)
+        {
+            tree->centroids[tree->numOfCentroids++] = key;
+        }
+        if (curNode->parentKey != DEFAULT_PARENT)
+        {
+            tree->subtreeSizes[curNode->parentKey] += tree->subtreeSizes[key];
+            if (tree->heights[key] + 1 > tree->heights[curNode->parentKey])
+            {
+                tree->heights[curNode->parentKey] = tree->heights[key] + 1;
+            }
+        }
+    }
+}
+
+/**
+ * Calculates the eccentricity of every node, its distance to the farthest node, and the radius of the tree,
+ * in two linear passes of rerooting instead of a BFS from every node. The nodes are ordered from the root as
+ * in a BFS, in the traversal array. Going up the order every node gets the two longest branches down from it
+ * through different children, going down every child gets the longest branch up from it, through its parent
+ * either higher up or down a sibling. The eccentricity is the longer of the longest branches down and up.
+ * @param tree the tree
+ */
+void treeEccentricities(Tree *tree)
+{
+    int *order = tree->traversal;
+    int *first = tree->downFirst;
+    int *second = tree->downSecond;
+    // the eccentricity of a node holds its longest branch up until its children are done.
+    int *up = tree->eccentricities;
+    int tail = 1;
+    order[0] = tree->root;
+    for (int head = 0; head < tail; ++head)
+    {
+        Node *curNode = &tree->nodes[order[head]];
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            order[tail++] = curNode->children[j];
+        }
+        first[curNode->key] = 0;
+        second[curNode->key] = 0;
+    }
+    for (int i = tree->numOfNodes - 1; i > 0; --i)
+    {
+        int key = order[i];
+        int parentKey = tree->nodes[key].parentKey;
+        int branch = first[key] + 1;
+        if (branch > first[parentKey])
+        {
+            second[parentKey] = first[parentKey];
+            first[parentKey] = branch;
+        }
+        else if (branch > second[parentKey])
+        {
+            second[parentKey] = branch;
+        }
+    }
+    up[tree->root] = 0;
+    tree->radius = tree->numOfNodes;
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        Node *curNode = &tree->nodes[order[i]];
+        int key = curNode->key;
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            int child = curNode->children[j];
+            // a child on the longest branch down turns to the second longest.
+            int sibling = (first[child] + 1 == first[key]) ? second[key] : first[key];
+            up[child] = 1 + ((up[key] > sibling) ? up[key] : sibling);
+        }
+        if (first[key] > up[key])
+        {
+            up[key] = first[key];
+        }
+        if (up[key] < tree->radius)
+        {
+            tree->radius = up[key];
+        }
+    }
+}
+
+/**
+ * Mixes the bits of a hash, the finalizer of splitmix64.
+ * @param hash the hash
+ * @return the mixed hash
+ */
+static unsigned long long mixHash(unsigned long long hash)
+{
+    hash ^= hash >> 30u;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27u;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31u;
+    return hash;
+}
+
+/**
+ * Compares two hashes for qsort.
+ * @param first the first hash
+ * @param second the second hash
+ * @return negative, zero or positive as the first hash is smaller, equal or larger
+ */
+static int compareHashes(const void *first, const void *second)
+{
+    unsigned long long a = *(const unsigned long long *)first;
+    unsigned long long b = *(const unsigned long long *)second;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Calculates a canonical hash of the tree that ignores the keys of the vertices and the given root, so
+ * isomorphic trees get the same hash. The tree is hung from its center, and in the manner of AHU every vertex
+ * gets the hash of the sorted hashes of its subtrees. A tree with two centers hangs from the middle of the
+ * edge between them and gets the hash of the sorted pair of the hashes of its halves.
+ * Takes O(n log n) time with no recursion. Has to be called after treeCenters.
+ * @param tree the tree, its traversal array and sets are used for the order and the parents from the center
+ * @return the hash
+ */
+unsigned long long canonicalHash(Tree *tree)
+{
+    int *order = tree->traversal;
+    int *parents = tree->sets;
+    unsigned long long *hashes = tree->subtreeHashes;
+    unsigned long long *scratch = tree->hashScratch;
+    int tail = 0;
+    for (int i = 0; i < tree->numOfCenters; ++i)
+    {
+        // two centers are each the parent of the other, so each half stays on its side.
+        order[tail++] = tree->centers[i];
+        parents[tree->centers[i]] = (tree->numOfCenters == MAX_CENTERS) ? tree->centers[1 - i] : DEFAULT_PARENT;
+    }
+    for (int head = 0; head < tail; ++head)
+    {
+        Node *curNode = &tree->nodes[order[head]];
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            if (curNode->children[j] != parents[curNode->key])
+            {
+                parents[curNode->children[j]] = curNode->key;
+                order[tail++] = curNode->children[j];
+            }
+        }
+        if (curNode->parentKey != DEFAULT_PARENT && curNode->parentKey != parents[curNode->key])
+        {
+            parents[curNode->parentKey] = curNode->key;
+            order[tail++] = curNode->parentKey;
+        }
+    }
+    for (int i = tree->numOfNodes - 1; i >= 0; --i)
+    {
+        Node *curNode = &tree->nodes[order[i]];
+        int numOfSubtrees = 0;
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            if (curNode->children[j] != parents[curNode->key])
+            {
+                scratch[numOfSubtrees++] = hashes[curNode->children[j]];
+            }
+        }
+        if (curNode->parentKey != DEFAULT_PARENT && curNode->parentKey != parents[curNode->key])
+        {
+            scratch[numOfSubtrees++] = hashes[curNode->parentKey];
+        }
+        qsort(scratch, (size_t)numOfSubtrees, sizeof(unsigned long long), compareHashes);
+        unsigned long long hash = HASH_OPEN;
+        for (int j = 0; j < numOfSubtrees; ++j)
+        {
+            hash = mixHash(hash * HASH_MULTIPLIER + scratch[j]);
+        }
+        hashes[curNode->key] = mixHash(hash + HASH_CLOSE);
+    }
+    if (tree->numOfCenters == 1)
+    {
+        return hashes[tree->centers[0]];
+    }
+    unsigned long long first = hashes[tree->centers[0]];
+    unsigned long long second = hashes[tree->centers[1]];
+    if (first > second)
+    {
+        unsigned long long temp = first;
+        first = second;
+        second = temp;
+    }
+    return mixHash(mixHash(HASH_PAIR + first) * HASH_MULTIPLIER + second);
+}
+
+/**
+ * Prints the one or two given keys in ascending order, and ends the line.
+ * @param keys the keys
+ * @param numOfKeys the number of keys
+ */
+void keysPrinter(const int *keys, int numOfKeys)
+{
+    if (numOfKeys == MAX_CENTERS && keys[0] > keys[1])
+    {
+        printf(" %d %d\n", keys[1], keys[0]);
+        return;
+    }
+    for (int i = 0; i < numOfKeys; ++i)
+    {
+        printf(" %d", keys[i]);
+    }
+    printf("\n");
+}
+
+/**
+ * Prints the structural metrics of the tree: the centroids, the centers and a table with the parent, the
+ * subtree size and the height of every node.
+ * @param tree the tree
+ */
+void metricsPrinter(Tree *tree)
+{
+    printf("Centroids:");
+    keysPrinter(tree->centroids, tree->numOfCentroids);
+    printf("Centers:");
+    keysPrinter(tree->centers, tree->numOfCenters);
+    printf("Vertex Parent Subtree-Size Height\n");
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        printf("%d %d %d %d\n", i, tree->nodes[i].parentKey, tree->subtreeSizes[i], tree->heights[i]);
+    }
+}
+
+/**
+ * Process the number as a char and turns it to an integer
+ * @param value the representation of the number as a string
+ * @param length the length of the number
+ * @param nPointer holds the number
+ * @return VALID_INPUT enum if the number was processed and INVALID_INPUT enum if the given value is not an integer.
+ */
+enum validityType processN(const char *value, int length, int *nPointer)
+{
+    if (length > 1 && value[0] == '0')
+    {
+        return INVALID_INPUT;
+    }
+    for (int i = 0; i < length; i++)
+    {
+        if ((value[i] < '0') || (value[i] > '9'))
+        {
+            return INVALID_INPUT;
+        }
+    }
+    * nPointer = (int)strtol(value, NULL , BASE);
+    return VALID_INPUT;
+}
+
+/**
+ * Parses a single non negative number in place, without copying it out of the file content.
+ * The number has to be made of digits only, can't have leading zeros and has to be smaller than limit.
+ * @param cursor points to the first char of the number, moved to the char right after it
+ * @param end the end of the current line
+ * @param limit the value the number has to be smaller than
+ * @param nPointer holds the number
+ * @return VALID_INPUT enum if the number was parsed and INVALID_INPUT enum otherwise.
+ */
+enum validityType parseNumber(const char **cursor, const char *end, long limit, int *nPointer)
+{
+    const char *c = *cursor;
+    long value = 0;
+    if (c == end || *c < '0' || *c > '9' || (*c == '0' && c + 1 != end && !isDelimiter(c[1])))
+    {
+        return INVALID_INPUT;
+    }
+    while (c != end && !isDelimiter(*c))
+    {
+        if (*c < '0' || *c > '9')
+        {
+            return INVALID_INPUT;
+        }
+        value = value * BASE + (*c - '0');
+        if (value >= limit)
+        {
+            return INVALID_INPUT;
+        }
+        c++;
+    }
+    *cursor = c;
+    *nPointer = (int)value;
+    return VALID_INPUT;
+}
+/**
+ * Returns the message that is printed for the given problem.
+ * @param problem the problem
+ * @return the message
+ */
+const char *problemMessage(enum validityType problem)
+{
+    if (problem == BAD_MEMORY_ALLOCATION)
+    {
+        return MEMORY_ALLOCATION_FAILED;
+    }
+    if (problem == FILE_WRITE_FAILED)
+    {
+        return FILE_WRITE_FAILED_MSG;
+    }
+    return INVALID_INPUT_MSG;
+}
+
+/**
+ * Exits the program - prints the relevant message and  frees the tree
+ * @param problem the current problem
+ * @param tree the tree
+ * @return 1 if there is a problem and 0 if not
+ */
+int exitPro(enum validityType problem, Tree *tree)
+{
+    if (problem != VALID_INPUT)
+    {
+        fprintf(stderr, "%s", problemMessage(problem));
+        freeTree(tree);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * Finds the representative of the set of the given node, halving the path to it on the way.
+ * @param sets the disjoint sets of the nodes, a negative value is minus the size of a set
+ * @param key the node
+ * @return the representative of the set
+ */
+static int findSet(int *sets, int key)
+{
+    while (sets[key] >= 0)
+    {
+        if (sets[sets[key]] >= 0)
+        {
+            sets[key] = sets[sets[key]];
+        }
+        key = sets[key];
+    }
+    return key;
+}
+
+/**
+ * Sets the parent of a node while the tree is parsed, and checks right away that the graph can still be a tree:
+ * there are at most numOfNodes - 1 edges, no node has two parents and the edge doesn't close a circle.
+ * The child is not added to the children of the parent.
+ * @param treeP pointer to the tree
+ * @param curNode the parent node
+ * @param sonKey the key of the child node
+ * @return NOT_A_TREE enum if the edge can't be in a tree and VALID_INPUT enum otherwise
+ */
+enum validityType linkChild(Tree *treeP, Node *curNode, int sonKey)
+{
+    Node *son = &treeP->nodes[sonKey];
+    if (treeP->numOfEdges >= treeP->numOfNodes - 1 || son->parentKey != DEFAULT_PARENT)
+    {
+        return NOT_A_TREE;
+    }
+    int parentSet = findSet(treeP->sets, curNode->key);
+    int sonSet = findSet(treeP->sets, sonKey);
+    if (parentSet == sonSet)
+    {
+        return NOT_A_TREE;
+    }
+    // union by size
+    if (treeP->sets[parentSet] > treeP->sets[sonSet])
+    {
+        int temp = parentSet;
+        parentSet = sonSet;
+        sonSet = temp;
+    }
+    treeP->sets[parentSet] += treeP->sets[sonSet];
+    treeP->sets[sonSet] = parentSet;
+    treeP->numOfEdges++;
+    treeP->childrenKeysSum += sonKey;
+    son->parentKey = curNode->key;
+    son->parent = curNode;
+    return VALID_INPUT;
+}
+
+/**
+ * Splits the last column of a line, the weight of the vertex or of the edge the line describes.
+ * @param line the first char of the line
+ * @param keysEnd holds the end of the line, and is moved to the end of the columns before the weight
+ * @param weight holds the weight
+ * @return INVALID_INPUT enum if there is no valid weight in the line and VALID_INPUT enum otherwise
+ */
+static enum validityType splitWeight(const char *line, const char **keysEnd, int *weight)
+{
+    const char *end = *keysEnd;
+    while (end != line && isDelimiter(end[-1]))
+    {
+        end--;
+    }
+    const char *start = end;
+    while (start != line && !isDelimiter(start[-1]))
+    {
+        start--;
+    }
+    int negative = start != end && *start == '-';
+    const char *digits = negative ? start + 1 : start;
+    int magnitude;
+    if (parseNumber(&digits, end, INT_MAX, &magnitude) == INVALID_INPUT)
+    {
+        return INVALID_INPUT;
+    }
+    *weight = negative ? -magnitude : magnitude;
+    while (start != line && isDelimiter(start[-1]))
+    {
+        start--;
+    }
+    *keysEnd = start;
+    return VALID_INPUT;
+}
+
+/**
+ * Checks the vertices given as arguments against the number of vertices of the graph and creates the tree,
+ * with every node in a set of its own.
+ * @param argv the given arguments, the vertices are argv[2] and argv[3]
+ * @param nPointer the number of vertices of the graph
+ * @param uPointer holds the first vertex
+ * @param vPointer holds the second vertex
+ * @param treeP pointer to the tree
+ * @return INVALID_INPUT enum if a vertex is not valid, BAD_MEMORY_ALLOCATION enum if the tree couldn't be
+ * created and VALID_INPUT enum otherwise
+ */
+enum validityType prepareTree(char **argv, const int *nPointer, int *uPointer, int *vPointer, Tree *treeP)
+{
+    if (processN(argv[2], (int)strlen(argv[2]), uPointer) == INVALID_INPUT ||
+        processN(argv[3], (int)strlen(argv[3]), vPointer) == INVALID_INPUT ||
+        *uPointer >= *nPointer || *vPointer >= *nPointer)
+    {
+        return INVALID_INPUT;
+    }
+    if (newTree(*nPointer, treeP) == BAD_MEMORY_ALLOCATION)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    for (int i = 0; i < *nPointer; ++i)
+    {
+        treeP->sets[i] = -1;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Finds the root of the parsed tree once all its edges were added.
+ * @param treeP pointer to the tree
+ * @return NOT_A_TREE enum if the graph is disconnected and VALID_INPUT enum otherwise
+ */
+enum validityType findRoot(Tree *treeP)
+{
+    if (treeP->numOfEdges != treeP->numOfNodes - 1)
+    {
+        // without circles, less than numOfNodes - 1 edges leave the graph disconnected.
+        return NOT_A_TREE;
+    }
+    // every node but the root is a child exactly once, so the root is the only key missing from the sum.
+    treeP->root = (int)((long long)treeP->numOfNodes * (treeP->numOfNodes - 1) / 2 - treeP->childrenKeysSum);
+    return VALID_INPUT;
+}
+
+/**
+ * Builds the children of every node from the parents, in two counting passes over the nodes: the first counts
+ * the children of every node, the second places them in the edges array after the children of the nodes
+ * before it.
+ * @param treeP pointer to the tree, with the parent of every node set
+ */
+void buildChildren(Tree *treeP)
+{
+    int offset = 0;
+    for (int i = 0; i < treeP->numOfNodes; ++i)
+    {
+        treeP->nodes[i].numOfChildren = 0;
+    }
+    for (int i = 0; i < treeP->numOfNodes; ++i)
+    {
+        if (treeP->nodes[i].parentKey != DEFAULT_PARENT)
+        {
+            treeP->nodes[treeP->nodes[i].parentKey].numOfChildren++;
+        }
+    }
+    for (int i = 0; i < treeP->numOfNodes; ++i)
+    {
+        Node *curNode = &treeP->nodes[i];
+        curNode->children = (curNode->numOfChildren > 0) ? treeP->edges + offset : NULL;
+        offset += curNode->numOfChildren;
+        curNode->numOfChildren = 0;
+    }
+    for (int i = 0; i < treeP->numOfNodes; ++i)
+    {
+        if (treeP->nodes[i].parentKey != DEFAULT_PARENT)
+        {
+            Node *parent = &treeP->nodes[treeP->nodes[i].parentKey];
+            parent->children[parent->numOfChildren++] = i;
+        }
+    }
+}
+
+/**
+ * Parses a line of an edge list or a parent array: exactly numOfKeys keys, where a parent array may hold
+ * "-1" or "-" for the parent of the root.
+ * @param line the first char of the line
+ * @param lineEnd the end of the line
+ * @param n the number of vertices
+ * @param numOfKeys the number of keys in the line
+ * @param keys holds the keys, DEFAULT_PARENT for a missing parent
+ * @return INVALID_INPUT enum if the line is not valid and VALID_INPUT enum otherwise
+ */
+enum validityType parseKeysLine(const char *line, const char *lineEnd, int n, int numOfKeys, int *keys)
+{
+    int count = 0;
+    while (line != lineEnd)
+    {
+        if (isDelimiter(*line))
+        {
+            line++;
+            continue;
+        }
+        if (count == numOfKeys)
+        {
+            return INVALID_INPUT;
+        }
+        if (*line == '-')
+        {
+            line += (line + 1 != lineEnd && line[1] == '1') ? 2 : 1;
+            if (line != lineEnd && !isDelimiter(*line))
+            {
+                return INVALID_INPUT;
+            }
+            keys[count++] = DEFAULT_PARENT;
+        }
+        else if (parseNumber(&line, lineEnd, n, &keys[count++]) == INVALID_INPUT)
+        {
+            return INVALID_INPUT;
+        }
+    }
+    return (count == numOfKeys) ? VALID_INPUT : INVALID_INPUT;
+}
+
+/**
+ * Sets the parent of a node read from an edge list or a parent array.
+ * @param treeP pointer to the tree
+ * @param parentKey the parent, DEFAULT_PARENT for a root
+ * @param sonKey the child
+ * @return NOT_A_TREE enum if the edge can't be in a tree and VALID_INPUT enum otherwise
+ */
+static enum validityType setParent(Tree *treeP, int parentKey, int sonKey)
+{
+    if (parentKey == DEFAULT_PARENT)
+    {
+        return VALID_INPUT;
+    }
+    return linkChild(treeP, &treeP->nodes[parentKey], sonKey);
+}
+
+/**
+ * Parses an edge list or a parent array in text: the number of vertices in the first line, then a
+ * "parent child" line for every one of the n - 1 edges, or the parent of every one of the n vertices.
+ * A weighted tree has the weight of the child as the last column of every line, the root of an edge list
+ * weighs 0. The children are built once all the parents are known.
+ * @param argv the given arguments
+ * @param nPointer holds the number of vertices
+ * @param uPointer holds the first vertex
+ * @param vPointer holds the second vertex
+ * @param treeP pointer to the tree
+ * @param graphFile the content of the file
+ * @return INVALID_INPUT enum if the input is not valid, NOT_A_TREE enum if it is not a tree,
+ * BAD_MEMORY_ALLOCATION enum if the tree couldn't be created and VALID_INPUT enum otherwise
+ */
+enum validityType parseKeysFile(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP,
+                                const GraphFile *graphFile)
+{
+    const char *cursor = graphFile->data;
+    const char *end = graphFile->data + graphFile->length;
+    const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+    lineEnd = (lineEnd == NULL) ? end : lineEnd;
+    int keys[2];
+    if (parseKeysLine(cursor, lineEnd, INT_MAX, 1, nPointer) == INVALID_INPUT || *nPointer < 0)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType result = prepareTree(argv, nPointer, uPointer, vPointer, treeP);
+    int isParentArray = treeP->inputFormat == PARENT_ARRAY_FORMAT;
+    int numOfLines = isParentArray ? *nPointer : *nPointer - 1;
+    int count = 0;
+    cursor = (lineEnd == end) ? end : lineEnd + 1;
+    while (result == VALID_INPUT && cursor != end)
+    {
+        lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        lineEnd = (lineEnd == NULL) ? end : lineEnd;
+        const char *keysEnd = lineEnd;
+        int weight = 0;
+        if (count == numOfLines || (treeP->withWeights && splitWeight(cursor, &keysEnd, &weight) == INVALID_INPUT) ||
+            parseKeysLine(cursor, keysEnd, *nPointer, isParentArray ? 1 : 2, keys) == INVALID_INPUT ||
+            (!isParentArray && (keys[0] < 0 || keys[1] < 0)))
+        {
+            return INVALID_INPUT;
+        }
+        // the weight of an edge is the weight of its child.
+        if (treeP->withWeights)
+        {
+            treeP->weights[isParentArray ? count : keys[1]] = weight;
+        }
+        result = isParentArray ? setParent(treeP, keys[0], count) : setParent(treeP, keys[0], keys[1]);
+        count++;
+        cursor = (lineEnd == end) ? end : lineEnd + 1;
+    }
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    if (count != numOfLines)
+    {
+        return INVALID_INPUT;
+    }
+    buildChildren(treeP);
+    return findRoot(treeP);
+}
+
+/**
+ * Reads a 32 bit little endian integer.
+ * @param bytes the bytes of the integer
+ * @return the integer
+ */
+int readLittleEndian(const char *bytes)
+{
+    unsigned int value = 0;
+    for (int i = KEY_BYTES - 1; i >= 0; --i)
+    {
+        value = (value << BITS_IN_BYTE) | (unsigned char)bytes[i];
+    }
+    return (int)value;
+}
+
+/**
+ * Writes a 32 bit little endian integer.
+ * @param value the integer
+ * @param bytes holds the bytes of the integer
+ */
+static void writeLittleEndian(int value, unsigned char *bytes)
+{
+    unsigned int bits = (unsigned int)value;
+    for (int i = 0; i < KEY_BYTES; ++i)
+    {
+        bytes[i] = (unsigned char)(bits >> (unsigned int)(i * BITS_IN_BYTE));
+    }
+}
+
+/**
+ * Parses a binary edge list or parent array: the number of vertices, then a parent and a child for every one
+ * of the n - 1 edges, or the parent of every one of the n vertices (-1 for the root), all 32 bit little endian.
+ * @param argv the given arguments
+ * @param nPointer holds the number of vertices
+ * @param uPointer holds the first vertex
+ * @param vPointer holds the second vertex
+ * @param treeP pointer to the tree
+ * @param graphFile the content of the file
+ * @return INVALID_INPUT enum if the input is not valid, NOT_A_TREE enum if it is not a tree,
+ * BAD_MEMORY_ALLOCATION enum if the tree couldn't be created and VALID_INPUT enum otherwise
+ */
+enum validityType parseBinaryFile(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP,
+                                  const GraphFile *graphFile)
+{
+    // the binary formats carry no weights.
+    if (treeP->withWeights || graphFile->length < KEY_BYTES || (*nPointer = readLittleEndian(graphFile->data)) < 0)
+    {
+        return INVALID_INPUT;
+    }
+    int isParentArray = treeP->inputFormat == BINARY_PARENT_ARRAY_FORMAT;
+    long long numOfKeys = isParentArray ? *nPointer : 2LL * (*nPointer - 1);
+    if (numOfKeys < 0 || graphFile->length != (size_t)(numOfKeys + 1) * KEY_BYTES)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType result = prepareTree(argv, nPointer, uPointer, vPointer, treeP);
+    const char *keys = graphFile->data + KEY_BYTES;
+    for (long long i = 0; result == VALID_INPUT && i < numOfKeys; i += isParentArray ? 1 : 2)
+    {
+        int parentKey = readLittleEndian(keys + i * KEY_BYTES);
+        int sonKey = isParentArray ? (int)i : readLittleEndian(keys + (i + 1) * KEY_BYTES);
+        if (parentKey < DEFAULT_PARENT || parentKey >= *nPointer || sonKey < 0 || sonKey >= *nPointer ||
+            (!isParentArray && parentKey == DEFAULT_PARENT))
+        {
+            return INVALID_INPUT;
+        }
+        result = setParent(treeP, parentKey, sonKey);
+    }
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    buildChildren(treeP);
+    return findRoot(treeP);
+}
+
+/**
+ * Parses the children listed in a line into the given array, without checking they can be in a tree.
+ * @param line the first char of the line, without its weight
+ * @param lineEnd the end of the line (the new line char or the end of the file)
+ * @param numOfNodes the number of nodes in the given tree
+ * @param children holds the keys of the children
+ * @param capacity the number of keys the children array can hold
+ * @param numOfChildren holds the number of children, 0 for a leaf
+ * @return INVALID_INPUT enum if the line is not valid, NOT_A_TREE enum if it lists more children than the
+ * capacity and VALID_INPUT enum otherwise
+ */
+enum validityType scanChildren(const char *line, const char *lineEnd, int numOfNodes, int *children,
+                               int capacity, int *numOfChildren)
+{
+    *numOfChildren = 0;
+    if (line != lineEnd && line[0] == '-')
+    {
+        if (line + 1 == lineEnd || (line[1] == '\r' && line + 2 == lineEnd))
+        {
+            return VALID_INPUT;
+        }
+        return INVALID_INPUT;
+    }
+    const char *cursor = line;
+    while (cursor != lineEnd)
+    {
+        if (isDelimiter(*cursor))
+        {
+            cursor++;
+            continue;
+        }
+        if (*numOfChildren == capacity)
+        {
+            return NOT_A_TREE;
+        }
+        if (parseNumber(&cursor, lineEnd, numOfNodes, &children[*numOfChildren]) == INVALID_INPUT)
+        {
+            return INVALID_INPUT;
+        }
+        (*numOfChildren)++;
+    }
+    return (*numOfChildren == 0) ? INVALID_INPUT : VALID_INPUT;
+}
+
+/**
+ * Process each line in the file - parses the children of the node in a single pass, stores them in the tree
+ * edges array and initializes the tree accordingly
+ * @param curNode the node that the given line describes it's children
+ * @param line the first char of the line that is processed, describes the children of the given node
+ * @param lineEnd the end of the line (the new line char or the end of the file)
+ * @param numOfNodes the number of nodes in the given tree
+ * @param treeP pointer to the tree
+ * @return INVALID_INPUT enum if the line is not valid, NOT_A_TREE enum if the line
+ * is valid but does not describe a tree and VALID_INPUT enum if it is ok
+ */
+enum validityType processLine(Node *curNode, const char *line, const char *lineEnd, const int *numOfNodes,
+                              Tree *treeP)
+{
+    int numOfChildren;
+    int *children = treeP->edges + treeP->numOfEdges;
+    enum validityType result = scanChildren(line, lineEnd, *numOfNodes, children,
+                                            treeP->numOfNodes - 1 - treeP->numOfEdges, &numOfChildren);
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    for (int i = 0; i < numOfChildren; ++i)
+    {
+        if (linkChild(treeP, curNode, children[i]) == NOT_A_TREE)
+        {
+            return NOT_A_TREE;
+        }
+    }
+    curNode->children = (numOfChildren > 0) ? children : NULL;
+    curNode->numOfChildren = numOfChildren;
+    return VALID_INPUT;
+}
+
+/**
+ * Maps the given graph file to memory. If the file can't be mapped (it is not a regular file) it is read
+ * into a buffer instead.
+ * @param fileP the graph file
+ * @param graphFile holds the content of the file
+ * @return INVALID_INPUT enum if the file is empty or can't be read, BAD_MEMORY_ALLOCATION enum if there
+ * is no memory for the buffer and VALID_INPUT enum otherwise
+ */
+enum validityType mapGraphFile(FILE *fileP, GraphFile *graphFile)
+{
+    struct stat fileStat;
+    graphFile->data = NULL;
+    graphFile->length = 0;
+    graphFile->isMapped = 0;
+    if (fstat(fileno(fileP), &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+    {
+        if (fileStat.st_size == 0)
+        {
+            return INVALID_INPUT;
+        }
+        void *data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileno(fileP), 0);
+        if (data != MAP_FAILED)
+        {
+            madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+            graphFile->data = (const char *)data;
+            graphFile->length = (size_t)fileStat.st_size;
+            graphFile->isMapped = 1;
+            return VALID_INPUT;
+        }
+    }
+    size_t capacity = 0;
+    char *buffer = NULL;
+    size_t readBytes;
+    do
+    {
+        if (graphFile->length + READ_CHUNK_SIZE > capacity)
+        {
+            capacity = capacity * 2 + READ_CHUNK_SIZE;
+            char *grown = (char *)realloc(buffer, capacity);
+            if (grown == NULL)
+            {
+                free(buffer);
+                return BAD_MEMORY_ALLOCATION;
+            }
+            buffer = grown;
+        }
+        readBytes = fread(buffer + graphFile->length, 1, READ_CHUNK_SIZE, fileP);
+        graphFile->length += readBytes;
+    } while (readBytes == READ_CHUNK_SIZE);
+    graphFile->data = buffer;
+    if (graphFile->length == 0)
+    {
+        return INVALID_INPUT;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Releases the content of the graph file.
+ * @param graphFile the content to release
+ */
+void unmapGraphFile(GraphFile *graphFile)
+{
+    if (graphFile->isMapped)
+    {
+        munmap((void *)graphFile->data, graphFile->length);
+    }
+    else
+    {
+        free((void *)graphFile->data);
+    }
+    graphFile->data = NULL;
+}
+
+/**
+ * structure that holds a chunk of the lines of the graph file, parsed by one thread. The chunks are cut at new
+ * line chars, so every line is in exactly one chunk.
+ */
+typedef struct ParseChunk
+{
+    Tree *tree;
+    const char *start;
+    const char *end;
+    int firstKey;
+    int numOfLines;
+    long long firstEdge;
+    long long numOfEdges;
+    enum validityType result;
+    pthread_t worker;
+    int started;
+} ParseChunk;
+
+/**
+ * Counts the lines of a chunk and the numbers in them, which places the chunk in the nodes and the edges arrays.
+ * @param arg the chunk
+ * @return NULL
+ */
+static void *countChunk(void *arg)
+{
+    ParseChunk *chunk = (ParseChunk *)arg;
+    int numOfLines = 0;
+    long long numOfEdges = 0;
+    int atToken = 0;
+    for (const char *c = chunk->start; c != chunk->end; ++c)
+    {
+        if (*c == '\n')
+        {
+            numOfLines++;
+            atToken = 0;
+        }
+        else if (isDelimiter(*c))
+        {
+            atToken = 0;
+        }
+        else
+        {
+            numOfEdges += !atToken && *c >= '0' && *c <= '9';
+            atToken = 1;
+        }
+    }
+    // only the last chunk can end without a new line char
+    if (chunk->start != chunk->end && chunk->end[-1] != '\n')
+    {
+        numOfLines++;
+    }
+    chunk->numOfLines = numOfLines;
+    chunk->numOfEdges = numOfEdges;
+    return NULL;
+}
+
+/**
+ * Parses the lines of a chunk into the children of their nodes, the children are stored in the edges array
+ * from the first edge of the chunk. Nothing is checked across lines, that is left to the merge.
+ * @param arg the chunk
+ * @return NULL
+ */
+static void *parseChunk(void *arg)
+{
+    ParseChunk *chunk = (ParseChunk *)arg;
+    Tree *treeP = chunk->tree;
+    int *children = treeP->edges + chunk->firstEdge;
+    int capacity = (int)chunk->numOfEdges;
+    int key = chunk->firstKey;
+    const char *cursor = chunk->start;
+    chunk->result = VALID_INPUT;
+    while (cursor != chunk->end)
+    {
+        const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(chunk->end - cursor));
+        if (lineEnd == NULL)
+        {
+            lineEnd = chunk->end;
+        }
+        Node *curNode = &treeP->nodes[key++];
+        int numOfChildren;
+        chunk->result = scanChildren(cursor, lineEnd, treeP->numOfNodes, children, capacity, &numOfChildren);
+        if (chunk->result != VALID_INPUT)
+        {
+            return NULL;
+        }
+        curNode->children = (numOfChildren > 0) ? children : NULL;
+        curNode->numOfChildren = numOfChildren;
+        children += numOfChildren;
+        capacity -= numOfChildren;
+        cursor = (lineEnd == chunk->end) ? chunk->end : lineEnd + 1;
+    }
+    return NULL;
+}
+
+/**
+ * Runs a function on every chunk, each on a thread of its own. The first chunk, and any chunk a thread
+ * couldn't be created for, runs on the calling thread.
+ * @param chunks the chunks
+ * @param numOfChunks the number of chunks
+ * @param function the function to run
+ */
+static void runOnChunks(ParseChunk *chunks, int numOfChunks, void *(*function)(void *))
+{
+    for (int i = 1; i < numOfChunks; ++i)
+    {
+        chunks[i].started = pthread_create(&chunks[i].worker, NULL, function, &chunks[i]) == 0;
+        if (!chunks[i].started)
+        {
+            function(&chunks[i]);
+        }
+    }
+    function(&chunks[0]);
+    for (int i = 1; i < numOfChunks; ++i)
+    {
+        if (chunks[i].started)
+        {
+            pthread_join(chunks[i].worker, NULL);
+        }
+    }
+}
+
+/**
+ * Parses the lines of the graph file on tree->numOfThreads threads. The lines are cut into chunks at new line
+ * chars, a first pass counts the lines and the children of every chunk so the chunks know where their nodes
+ * and children are, and a second pass parses the chunks in parallel. A serial merge then checks no node has
+ * two parents and there are no circles, as the serial parse does while it reads.
+ * @param treeP pointer to the tree, prepared for nPointer nodes
+ * @param nPointer the number of vertices of the graph
+ * @param body the first char of the second line of the file
+ * @param end the end of the file
+ * @return INVALID_INPUT enum if a line is not valid, NOT_A_TREE enum if the lines don't describe a tree,
+ * BAD_MEMORY_ALLOCATION enum if there is no memory for the chunks and VALID_INPUT enum otherwise
+ */
+enum validityType parseChunks(Tree *treeP, const int *nPointer, const char *body, const char *end)
+{
+    int numOfChunks = treeP->numOfThreads;
+    ParseChunk *chunks = (ParseChunk *)malloc(sizeof(ParseChunk) * (size_t)numOfChunks);
+    if (chunks == NULL)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    const char *chunkStart = body;
+    for (int i = 0; i < numOfChunks; ++i)
+    {
+        const char *chunkEnd = end;
+        if (i < numOfChunks - 1)
+        {
+            chunkEnd = body + (end - body) / numOfChunks * (i + 1);
+            if (chunkEnd < chunkStart)
+            {
+                chunkEnd = chunkStart;
+            }
+            const char *newLine = (const char *)memchr(chunkEnd, '\n', (size_t)(end - chunkEnd));
+            chunkEnd = (newLine == NULL) ? end : newLine + 1;
+        }
+        chunks[i].tree = treeP;
+        chunks[i].start = chunkStart;
+        chunks[i].end = chunkEnd;
+        chunkStart = chunkEnd;
+    }
+    runOnChunks(chunks, numOfChunks, countChunk);
+    long long numOfLines = 0;
+    long long numOfEdges = 0;
+    for (int i = 0; i < numOfChunks; ++i)
+    {
+        chunks[i].firstKey = (int)numOfLines;
+        chunks[i].firstEdge = numOfEdges;
+        numOfLines += chunks[i].numOfLines;
+        numOfEdges += chunks[i].numOfEdges;
+    }
+    enum validityType result = VALID_INPUT;
+    if (numOfLines != *nPointer)
+    {
+        result = INVALID_INPUT;
+    }
+    else if (numOfEdges > *nPointer - 1)
+    {
+        result = NOT_A_TREE;
+    }
+    else
+    {
+        runOnChunks(chunks, numOfChunks, parseChunk);
+        for (int i = 0; i < numOfChunks && result == VALID_INPUT; ++i)
+        {
+            result = chunks[i].result;
+        }
+    }
+    free(chunks);
+    // the merge: the edges are linked in the order of the file, which finds repeated parents and circles.
+    for (int i = 0; i < *nPointer && result == VALID_INPUT; ++i)
+    {
+        Node *curNode = &treeP->nodes[i];
+        for (int j = 0; j < curNode->numOfChildren && result == VALID_INPUT; ++j)
+        {
+            result = linkChild(treeP, curNode, curNode->children[j]);
+        }
+    }
+    return (result == VALID_INPUT) ? findRoot(treeP) : result;
+}
+
+/**
+ * Checks if the given file content is a valid input, checking each line is valid, and checks if the number of
+ * vertices is valid comparing the given input. Every byte of the file is visited once and there is no limit
+ * on the length of a line.
+ * @param argv the arguments that are given to the program
+ * @param nPointer A pointer to the number of vertices in the graph - the first line in the file
+ * @param uPointer A pointer to the second argument that is given as an input - the first of the vertices
+ * @param vPointer A pointer to the third argument that is given as an input - the second of the vertices
+ * @param treeP A pointer to the tree
+ * @param graphFile the content of the file that is given as the first argument
+ * @return INVALID INPUT enum if the file is not valid or one of the lines in the file is not valid,
+ * NOT_A_TREE enum if the given file does not describe a tree, BAD_MEMORY_ALLOCATION enum
+ * if there is no memory allocation and VALID_INPUT enum if the file was processed successfully
+ */
+enum validityType parseGraphFile(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP,
+                                 const GraphFile *graphFile)
+{
+    const char *cursor = graphFile->data;
+    const char *end = graphFile->data + graphFile->length;
+    const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+    if (lineEnd == NULL)
+    {
+        lineEnd = end;
+    }
+    // exactly one number in the first line
+    if (parseNumber(&cursor, lineEnd, INT_MAX, nPointer) == INVALID_INPUT)
+    {
+        return INVALID_INPUT;
+    }
+    while (cursor != lineEnd)
+    {
+        if (!isDelimiter(*cursor++))
+        {
+            return INVALID_INPUT;
+        }
+    }
+    enum validityType prepareResult = prepareTree(argv, nPointer, uPointer, vPointer, treeP);
+    if (prepareResult != VALID_INPUT)
+    {
+        return prepareResult;
+    }
+    cursor = (lineEnd == end) ? end : lineEnd + 1;
+    if (treeP->numOfThreads > 1 && !treeP->withWeights && end - cursor >= PARALLEL_PARSE_MIN_BYTES)
+    {
+        return parseChunks(treeP, nPointer, cursor, end);
+    }
+    int count_lines = 0;
+    while (cursor != end)
+    {
+        lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        if (lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        if (count_lines == *nPointer)
+        {
+            return INVALID_INPUT;
+        }
+        const char *keysEnd = lineEnd;
+        if (treeP->withWeights && splitWeight(cursor, &keysEnd, &treeP->weights[count_lines]) == INVALID_INPUT)
+        {
+            return INVALID_INPUT;
+        }
+        enum validityType processResult = processLine(&treeP->nodes[count_lines], cursor, keysEnd, nPointer,
+                                                      treeP);
+        count_lines++;
+        if (processResult != VALID_INPUT)
+        {
+            // the graph is rejected as soon as a line shows it is not a valid tree.
+            return processResult;
+        }
+        cursor = (lineEnd == end) ? end : lineEnd + 1;
+    }
+    if (count_lines != *nPointer) // less vertices than declared in the first line
+    {
+        return INVALID_INPUT;
+    }
+    return findRoot(treeP);
+}
+
+/**
+ * Checks if the given input is a valid input. The file is mapped to memory and parsed in place.
+ * @param argv the arguments that are given to the program
+ * @param nPointer A pointer to the number of vertices in the graph - the first line in the file
+ * @param uPointer A pointer to the second argument that is given as an input - the first of the vertices
+ * @param vPointer A pointer to the third argument that is given as an input - the second of the vertices
+ * @param treeP A pointer to the tree
+ * @param fileP the file that is given as the first argument
+ * @return INVALID INPUT enum if the file is not valid or one of the lines in the file is not valid,
+ * NOT_A_TREE enum if the given file does not describe a tree, BAD_MEMORY_ALLOCATION enum
+ * if there is no memory allocation and VALID_INPUT enum if the file was processed successfully
+ */
+enum validityType inputValidityCheck(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP, FILE *fileP)
+{
+    if (fileP == NULL)
+    {
+        return INVALID_INPUT;
+    }
+    GraphFile graphFile;
+    enum validityType mapResult = mapGraphFile(fileP, &graphFile);
+    if (mapResult != VALID_INPUT)
+    {
+        unmapGraphFile(&graphFile);
+        return mapResult;
+    }
+    if (treeP->profile != NULL && !graphFile.isMapped)
+    {
+        treeP->profile->heapBytes += graphFile.length;
+    }
+    profilePhase(treeP->profile, READ_PHASE);
+    enum validityType parseResult;
+    if (treeP->inputFormat == EDGE_LIST_FORMAT || treeP->inputFormat == PARENT_ARRAY_FORMAT)
+    {
+        parseResult = parseKeysFile(argv, nPointer, uPointer, vPointer, treeP, &graphFile);
+    }
+    else if (treeP->inputFormat == BINARY_EDGE_LIST_FORMAT || treeP->inputFormat == BINARY_PARENT_ARRAY_FORMAT)
+    {
+        parseResult = parseBinaryFile(argv, nPointer, uPointer, vPointer, treeP, &graphFile);
+    }
+    else
+    {
+        parseResult = parseGraphFile(argv, nPointer, uPointer, vPointer, treeP, &graphFile);
+    }
+    unmapGraphFile(&graphFile);
+    return parseResult;
+}
+
+/**
+ * Adds the given values to a running checksum of a cache file.
+ * @param checksum the running checksum, two 32 bit sums packed together
+ * @param values the values to add
+ * @param count the number of values
+ */
+void cacheChecksum(unsigned long long *checksum, const int *values, size_t count)
+{
+    unsigned long long low = *checksum & 0xffffffffULL;
+    unsigned long long high = *checksum >> 32u;
+    for (size_t i = 0; i < count; ++i)
+    {
+        low = (low + (unsigned int)values[i]) % CACHE_CHECKSUM_MOD;
+        high = (high + low) % CACHE_CHECKSUM_MOD;
+    }
+    *checksum = (high << 32u) | low;
+}
+
+/**
+ * Writes the given values to the cache file and adds them to the checksum.
+ * @param values the values to write
+ * @param count the number of values
+ * @param checksum the running checksum
+ * @param cacheFile the cache file
+ * @return VALID_INPUT enum if the values were written and FILE_WRITE_FAILED enum otherwise
+ */
+enum validityType writeCacheArray(const int *values, size_t count, unsigned long long *checksum, FILE *cacheFile)
+{
+    cacheChecksum(checksum, values, count);
+    if (fwrite(values, sizeof(int), count, cacheFile) != count)
+    {
+        return FILE_WRITE_FAILED;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Saves a validated tree to a binary cache file: a header followed by the parent array, the children
+ * offsets, the children (in compressed sparse rows form) and the depth of every node.
+ * Has to be called after branchLengths, while the distances of the nodes are their depths.
+ * @param tree the validated tree
+ * @param cachePath the path of the cache file
+ * @return VALID_INPUT enum if the cache was saved, FILE_WRITE_FAILED enum if it couldn't be written
+ * and BAD_MEMORY_ALLOCATION enum if there was no memory
+ */
+enum validityType saveTreeCache(Tree *tree, const char *cachePath)
+{
+    CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, tree->numOfNodes, tree->numOfEdges, tree->root,
+                          tree->minBranch, tree->maxBranch, 1, 0};
+    cacheChecksum(&header.checksum, (const int *)&header, CACHE_HEADER_FIELDS);
+    int *buffer = (int *)malloc(sizeof(int) * CACHE_BUFFER_LEN);
+    if (buffer == NULL)
     {
         return BAD_MEMORY_ALLOCATION;
     }
-    while (fgets(currentLine, MAX_LINE_LEN, fileP))
+    FILE *cacheFile = fopen(cachePath, "wb");
+    if (cacheFile == NULL)
+    {
+        free(buffer);
+        return FILE_WRITE_FAILED;
+    }
+    enum validityType result = VALID_INPUT;
+    if (fwrite(&header, sizeof(header), 1, cacheFile) != 1)
+    {
+        result = FILE_WRITE_FAILED;
+    }
+    // the parent array, the offsets and the depths, each written through the buffer.
+    for (int array = 0; array < CACHE_NUM_OF_NODE_ARRAYS && result == VALID_INPUT; ++array)
+    {
+        int offset = 0;
+        int count = 0;
+        for (int i = 0; i < tree->numOfNodes && result == VALID_INPUT; ++i)
+        {
+            Node *curNode = &tree->nodes[i];
+            buffer[count++] = (array == 0) ? curNode->parentKey : (array == 1) ? offset : curNode->distance;
+            offset += curNode->numOfChildren;
+            if (count == CACHE_BUFFER_LEN || i == tree->numOfNodes - 1)
+            {
+                result = writeCacheArray(buffer, (size_t)count, &header.checksum, cacheFile);
+                count = 0;
+            }
+        }
+        if (array == 1 && result == VALID_INPUT)
+        {
+            // the last offset closes the children of the last node.
+            result = writeCacheArray(&offset, 1, &header.checksum, cacheFile);
+        }
+        if (array == 1 && result == VALID_INPUT)
+        {
+            result = writeCacheArray(tree->edges, (size_t)tree->numOfEdges, &header.checksum, cacheFile);
+        }
+    }
+    if (result == VALID_INPUT &&
+        (fseek(cacheFile, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, cacheFile) != 1))
+    {
+        result = FILE_WRITE_FAILED;
+    }
+    if (fclose(cacheFile) != 0)
+    {
+        result = FILE_WRITE_FAILED;
+    }
+    free(buffer);
+    return result;
+}
+
+/**
+ * Checks that the arrays loaded from a tree cache describe one tree: the children start at offset 0, the
+ * parent of every child is the node it is listed under, and a BFS from the root over the children reaches
+ * every node exactly once, so the root is the only node without a parent and the parents have no cycle.
+ * The traversal array is the queue and the previus nodes mark the nodes that were reached.
+ * @param treeP pointer to the loaded tree
+ * @param offsets the children offsets of the cache
+ * @return INVALID_INPUT enum if the arrays are not one tree and VALID_INPUT enum otherwise
+ */
+static enum validityType checkCachedTree(Tree *treeP, const int *offsets)
+{
+    if (offsets[0] != 0 || offsets[treeP->numOfNodes] != treeP->numOfEdges)
+    {
+        return INVALID_INPUT;
+    }
+    int *queue = treeP->traversal;
+    int reached = 1;
+    int duplicate = 0;
+    queue[0] = treeP->root;
+    for (int head = 0; head < reached && !duplicate; ++head)
+    {
+        Node *curNode = &treeP->nodes[queue[head]];
+        for (int i = 0; i < curNode->numOfChildren && !duplicate; ++i)
+        {
+            Node *child = &treeP->nodes[curNode->children[i]];
+            duplicate = child->parent != curNode || child->previus != NULL || reached == treeP->numOfNodes;
+            child->previus = curNode;
+            queue[reached++] = child->key;
+        }
+    }
+    for (int i = 0; i < reached; ++i)
+    {
+        treeP->nodes[queue[i]].previus = NULL;
+    }
+    return (!duplicate && reached == treeP->numOfNodes) ? VALID_INPUT : INVALID_INPUT;
+}
+
+/**
+ * Loads a tree that was saved by saveTreeCache. The cache file is mapped to memory, its header and checksum
+ * are checked and the tree is built from the arrays without parsing it again: the ranges of the keys are
+ * checked and a single pass checks that the arrays describe one tree. The cache carries no weights, so a
+ * weighted tree is not loaded from it.
+ * @param argv the arguments that are given to the program
+ * @param nPointer A pointer to the number of vertices in the graph
+ * @param uPointer A pointer to the first of the vertices
+ * @param vPointer A pointer to the second of the vertices
+ * @param treeP A pointer to the tree
+ * @param fileP the cache file that is given as the first argument
+ * @return INVALID_INPUT enum if the cache or the vertices are not valid, BAD_MEMORY_ALLOCATION enum
+ * if there is no memory allocation and VALID_INPUT enum if the tree was loaded
+ */
+enum validityType loadTreeCache(char **argv, int *nPointer, int *uPointer, int *vPointer, Tree *treeP,
+                                FILE *fileP)
+{
+    struct stat fileStat;
+    // the cache carries no weights.
+    if (treeP->withWeights || fileP == NULL || fstat(fileno(fileP), &fileStat) != 0 ||
+        (size_t)fileStat.st_size < sizeof(CacheHeader))
+    {
+        return INVALID_INPUT;
+    }
+    size_t length = (size_t)fileStat.st_size;
+    void *data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(fileP), 0);
+    if (data == MAP_FAILED)
+    {
+        return INVALID_INPUT;
+    }
+    const CacheHeader *header = (const CacheHeader *)data;
+    const int *parents = (const int *)(header + 1);
+    size_t n = (size_t)header->numOfNodes;
+    int hasDepth = header->hasDepth;
+    size_t payloadLen = n * (hasDepth ? 3 : 2) + 1 + (size_t)header->numOfEdges;
+    unsigned long long checksum = 0;
+    enum validityType result = VALID_INPUT;
+    if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION || header->numOfNodes <= 0 ||
+        header->numOfEdges != header->numOfNodes - 1 || (hasDepth != 0 && hasDepth != 1) ||
+        length != sizeof(CacheHeader) + payloadLen * sizeof(int))
+    {
+        result = INVALID_INPUT;
+    }
+    else
+    {
+        cacheChecksum(&checksum, (const int *)header, CACHE_HEADER_FIELDS);
+        cacheChecksum(&checksum, parents, payloadLen);
+        if (checksum != header->checksum || header->root < 0 || header->root >= header->numOfNodes ||
+            parents[header->root] != DEFAULT_PARENT ||
+            processN(argv[2], (int)strlen(argv[2]), uPointer) == INVALID_INPUT ||
+            processN(argv[3], (int)strlen(argv[3]), vPointer) == INVALID_INPUT ||
+            *uPointer >= header->numOfNodes || *vPointer >= header->numOfNodes)
+        {
+            result = INVALID_INPUT;
+        }
+    }
+    if (result == VALID_INPUT)
+    {
+        *nPointer = header->numOfNodes;
+        result = newTree(*nPointer, treeP);
+    }
+    if (result == VALID_INPUT)
+    {
+        const int *offsets = parents + n;
+        const int *children = offsets + n + 1;
+        memcpy(treeP->edges, children, sizeof(int) * (size_t)header->numOfEdges);
+        treeP->numOfEdges = header->numOfEdges;
+        treeP->root = header->root;
+        treeP->minBranch = header->minBranch;
+        treeP->maxBranch = header->maxBranch;
+        for (int i = 0; i < *nPointer && result == VALID_INPUT; ++i)
+        {
+            Node *curNode = &treeP->nodes[i];
+            if (parents[i] < DEFAULT_PARENT || parents[i] >= *nPointer || offsets[i] > offsets[i + 1] ||
+                offsets[i + 1] > header->numOfEdges)
+            {
+                result = INVALID_INPUT;
+                break;
+            }
+            curNode->parentKey = parents[i];
+            curNode->parent = (parents[i] == DEFAULT_PARENT) ? NULL : &treeP->nodes[parents[i]];
+            curNode->numOfChildren = offsets[i + 1] - offsets[i];
+            curNode->children = (curNode->numOfChildren == 0) ? NULL : treeP->edges + offsets[i];
+            curNode->distance = hasDepth ? offsets[n + 1 + (size_t)header->numOfEdges + (size_t)i] : 0;
+        }
+    }
+    for (int i = 0; i < header->numOfEdges && result == VALID_INPUT; ++i)
+    {
+        if (treeP->edges[i] < 0 || treeP->edges[i] >= *nPointer)
+        {
+            result = INVALID_INPUT;
+        }
+    }
+    if (result == VALID_INPUT)
+    {
+        // the checksum is no proof against an edited cache, and the analysis relies on a tree.
+        result = checkCachedTree(treeP, parents + n);
+    }
+    munmap(data, length);
+    if (result == VALID_INPUT && !hasDepth)
+    {
+        branchLengths(treeP);
+    }
+    return result;
+}
+
+/**
+ * Writes the eccentricities of the tree as a column, the eccentricity of vertex i first: a line for every
+ * vertex, or 32 bit little endian integers as in the binary graph formats.
+ * @param tree the tree, with its eccentricities calculated
+ * @param path the path of the file, "-" for the standard output
+ * @param binary 1 for the binary column and 0 for the text column
+ * @return VALID_INPUT enum if the column was written and FILE_WRITE_FAILED enum otherwise
+ */
+enum validityType eccentricitiesWriter(const Tree *tree, const char *path, int binary)
+{
+    int toStdout = strcmp(path, STDIN_PATH) == 0;
+    FILE *out = toStdout ? stdout : fopen(path, binary ? "wb" : "w");
+    if (out == NULL)
+    {
+        return FILE_WRITE_FAILED;
+    }
+    int failed = 0;
+    for (int i = 0; i < tree->numOfNodes && !failed; ++i)
+    {
+        if (binary)
+        {
+            unsigned char bytes[KEY_BYTES];
+            writeLittleEndian(tree->eccentricities[i], bytes);
+            failed = fwrite(bytes, 1, KEY_BYTES, out) != KEY_BYTES;
+        }
+        else
+        {
+            failed = fprintf(out, "%d\n", tree->eccentricities[i]) < 0;
+        }
+    }
+    if ((toStdout && fflush(out) != 0) || (!toStdout && fclose(out) != 0))
+    {
+        failed = 1;
+    }
+    return failed ? FILE_WRITE_FAILED : VALID_INPUT;
+}
+
+/**
+ * Prints the information about the tree, all but the path
+ * @param tree the tree that needs to be printed
+ * @param out the stream to print to
+ */
+void treeSummaryPrinter(Tree *tree, FILE *out)
+{
+    fprintf(out, "Root Vertex: %d\n", tree->root);
+    fprintf(out, "Vertices Count: %d\n", tree->numOfNodes);
+    fprintf(out, "Edges Count: %d\n", tree->numOfEdges);
+    fprintf(out, "Length of Minimal Branch: %d\n", tree->minBranch);
+    fprintf(out, "Length of Maximal Branch: %d\n", tree->maxBranch);
+    fprintf(out, "Diameter Length: %d\n", tree->diameter);
+}
+
+/**
+ * Prints the information about the tree
+ * @param tree the tree that needs to be printed
+ * @param uKey the first of the vertices given as input
+ * @param vKey the second of the vertices given as input
+ * @param out the stream to print to
+ */
+void treePrinter(Tree *tree, int uKey, int vKey, FILE *out)
+{
+    treeSummaryPrinter(tree, out);
+    fprintf(out, "Shortest Path Between %d and %d:", uKey, vKey);
+    for (int i = tree->pathLen - 1; i >= 0; --i)
+    {
+        fprintf(out, " %d", tree->path[i]);
+    }
+    fprintf(out, "\n");
+}
+
+/**
+ * Analyzes the graph of one manifest row on the given tree and keeps the output in the row.
+ * A row that fails keeps its problem, and runBatch prints its message to the standard error.
+ * @param tree the tree of the worker, reused between the rows
+ * @param row the manifest row
+ * @param context the batch context, with the options of all the rows
+ */
+void analyzeBatchRow(Tree *tree, BatchRow *row, const BatchContext *context)
+{
+    int n, u, v;
+    FILE *out = open_memstream(&row->output, &row->outputLen);
+    if (out == NULL)
+    {
+        row->output = NULL;
+        row->result = BAD_MEMORY_ALLOCATION;
+        return;
+    }
+    row->result = INVALID_INPUT;
+    if (row->numOfFields == NUM_ARGS)
+    {
+        FILE *fileP = fopen(row->argv[1], "r");
+        tree->inputFormat = context->inputFormat;
+        tree->withCanonicalHash = context->withCanonicalHash;
+        row->result = inputValidityCheck(row->argv, &n, &u, &v, tree, fileP);
+        if (fileP != NULL)
+        {
+            fclose(fileP);
+        }
+    }
+    if (row->result == VALID_INPUT)
+    {
+        branchLengths(tree);
+        diameterAndPath(tree, &tree->nodes[u], &tree->nodes[v]);
+        treePrinter(tree, u, v, out);
+        if (tree->withCanonicalHash)
+        {
+            treeCenters(tree);
+            fprintf(out, CANONICAL_HASH_FORMAT, canonicalHash(tree));
+        }
+    }
+    if (fclose(out) != 0)
+    {
+        row->result = FILE_WRITE_FAILED;
+    }
+    reuseTree(tree);
+}
+
+/**
+ * A worker of a batch analysis. Takes the next row until all the rows are taken, all the rows of the worker
+ * are analyzed on one tree so its arena is allocated again only for a larger graph.
+ * @param arg the batch context
+ * @return NULL
+ */
+static void *batchWorker(void *arg)
+{
+    BatchContext *context = (BatchContext *)arg;
+    Tree tree;
+    initiateTree(&tree);
+    int i;
+    while ((i = __atomic_fetch_add(&context->nextRow, 1, __ATOMIC_RELAXED)) < context->numOfRows)
+    {
+        analyzeBatchRow(&tree, &context->rows[i], context);
+    }
+    freeTree(&tree);
+    return NULL;
+}
+
+/**
+ * Reads the rows of a batch manifest, each row holds a graph file path and two vertices.
+ * Empty lines are skipped.
+ * @param manifest the manifest file
+ * @param context holds the rows
+ * @return VALID_INPUT enum if the manifest was read and BAD_MEMORY_ALLOCATION enum otherwise
+ */
+enum validityType readManifest(FILE *manifest, BatchContext *context)
+{
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    int capacity = 0;
+    context->rows = NULL;
+    context->numOfRows = 0;
+    context->nextRow = 0;
+    while (getline(&line, &lineCapacity, manifest) != -1)
     {
-        count_lines++;
-        if (count_lines - 1 > *nPointer)
+        if (strspn(line, MANIFEST_DELIMITERS) == strlen(line))
         {
-            return INVALID_INPUT;
+            continue;
         }
-        enum validityType processResult = processLine(&treeP->nodes[count_lines - 2], currentLine, nPointer, treeP);
-        if (processResult == BAD_MEMORY_ALLOCATION)
+        if (context->numOfRows == capacity)
         {
-            return BAD_MEMORY_ALLOCATION;
+            capacity = (capacity == 0) ? 1 : 2 * capacity;
+            BatchRow *rows = (BatchRow *)realloc(context->rows, sizeof(BatchRow) * (size_t)capacity);
+            if (rows == NULL)
+            {
+                free(line);
+                return BAD_MEMORY_ALLOCATION;
+            }
+            context->rows = rows;
         }
-        else if (processResult == INVALID_INPUT)
+        BatchRow *row = &context->rows[context->numOfRows++];
+        char *savePointer;
+        row->line = line;
+        row->output = NULL;
+        row->outputLen = 0;
+        row->numOfFields = 0;
+        row->argv[0] = NULL;
+        for (char *field = strtok_r(line, MANIFEST_DELIMITERS, &savePointer); field != NULL;
+             field = strtok_r(NULL, MANIFEST_DELIMITERS, &savePointer))
         {
-            return INVALID_INPUT;
+            if (row->numOfFields < NUM_ARGS)
+            {
+                row->argv[row->numOfFields + 1] = field;
+            }
+            row->numOfFields++;
+        }
+        line = NULL;
+        lineCapacity = 0;
+    }
+    free(line);
+    return VALID_INPUT;
+}
+
+/**
+ * Analyzes all the graphs of a batch manifest on a fixed pool of workers and prints their outputs in the
+ * order of the manifest, every output as the program would print it for that row alone: the summary to the
+ * standard output and the message of a row that failed to the standard error.
+ * @param manifestPath the path of the manifest
+ * @param options the options of all the rows, the number of threads is the number of workers (0 for the number
+ * of online processors)
+ * @return EXIT_SUCCESS if all the rows were analyzed and EXIT_FAILURE otherwise
+ */
+int runBatch(const char *manifestPath, const Options *options)
+{
+    int numOfWorkers = options->numOfThreads;
+    BatchContext context;
+    pthread_t workers[MAX_THREADS];
+    FILE *manifest = fopen(manifestPath, "r");
+    if (manifest == NULL)
+    {
+        fprintf(stderr, MANIFEST_OPEN_FAILED_MSG);
+        return EXIT_FAILURE;
+    }
+    enum validityType readResult = readManifest(manifest, &context);
+    context.inputFormat = options->inputFormat;
+    context.withCanonicalHash = options->withCanonicalHash;
+    fclose(manifest);
+    if (readResult != VALID_INPUT)
+    {
+        numOfWorkers = -1;
+    }
+    else if (numOfWorkers == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        numOfWorkers = (online < 1) ? 1 : (online > MAX_THREADS) ? MAX_THREADS : (int)online;
+    }
+    if (numOfWorkers > context.numOfRows)
+    {
+        numOfWorkers = context.numOfRows;
+    }
+    int numOfStarted = 0;
+    while (numOfStarted < numOfWorkers &&
+           pthread_create(&workers[numOfStarted], NULL, batchWorker, &context) == 0)
+    {
+        numOfStarted++;
+    }
+    if (numOfStarted == 0 && numOfWorkers > 0)
+    {
+        // the calling thread analyzes the rows when no worker could be started.
+        batchWorker(&context);
+    }
+    for (int i = 0; i < numOfStarted; ++i)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    int exitCode = (readResult == VALID_INPUT) ? EXIT_SUCCESS : EXIT_FAILURE;
+    for (int i = 0; i < context.numOfRows; ++i)
+    {
+        if (readResult == VALID_INPUT && context.rows[i].output != NULL)
+        {
+            fwrite(context.rows[i].output, 1, context.rows[i].outputLen, stdout);
         }
-        else if (processResult == NOT_A_TREE)
+        if (readResult == VALID_INPUT && context.rows[i].result != VALID_INPUT)
         {
-            isAtree = NOT_A_TREE;
+            // the message comes after the outputs of the rows before it.
+            fflush(stdout);
+            fprintf(stderr, "%s", problemMessage(context.rows[i].result));
         }
+        if (readResult != VALID_INPUT || context.rows[i].result != VALID_INPUT)
+        {
+            exitCode = EXIT_FAILURE;
+        }
+        free(context.rows[i].output);
+        free(context.rows[i].line);
     }
-    if (count_lines - 1 != *nPointer) // more vertex than declared in the first line
+    if (readResult != VALID_INPUT)
     {
-        return INVALID_INPUT;
+        fprintf(stderr, MEMORY_ALLOCATION_FAILED);
     }
-    if (isAtree == NOT_A_TREE)
+    free(context.rows);
+    return exitCode;
+}
+
+/**
+ * Sets the weight of a vertex in the segment tree and recalculates the segments above it.
+ * @param decomposition the heavy light decomposition
+ * @param key the vertex
+ * @param weight the new weight
+ */
+void setPathWeight(HeavyLight *decomposition, int key, int weight)
+{
+    int n = decomposition->numOfNodes;
+    int i = decomposition->positions[key] + n;
+    decomposition->sums[i] = weight;
+    decomposition->maxima[i] = weight;
+    for (i /= 2; i >= 1; i /= 2)
     {
-        return NOT_A_TREE;
+        decomposition->sums[i] = decomposition->sums[2 * i] + decomposition->sums[2 * i + 1];
+        decomposition->maxima[i] = (decomposition->maxima[2 * i] > decomposition->maxima[2 * i + 1])
+                                   ? decomposition->maxima[2 * i] : decomposition->maxima[2 * i + 1];
     }
-    fclose(fileP);
-    return VALID_INPUT;
 }
 
 /**
- * Finds the root of the tree
- * @param tree the tree to find the root in
- * @return NOT_A_TREE enum if the given graph is not a tree and VALID_INPUT enum otherwise
+ * Adds the weights of the positions first to last of the segment tree to the sum and the maximum.
+ * @param decomposition the heavy light decomposition
+ * @param first the first position
+ * @param last the last position
+ * @param sum holds the sum
+ * @param maximum holds the maximum
  */
-enum validityType findRoot(Tree *tree)
+static void segmentQuery(const HeavyLight *decomposition, int first, int last, long long *sum, long long *maximum)
 {
-    int noParent = 0;
-    int noParentIndex = -1;
-    for (int i = 0; i< tree->numOfNodes; ++i)
+    int n = decomposition->numOfNodes;
+    for (int low = first + n, high = last + n + 1; low < high; low /= 2, high /= 2)
     {
-        if (tree->nodes[i].parentKey == DEFAULT_PARENT)
+        if (low & 1)
+        {
+            *sum += decomposition->sums[low];
+            *maximum = (decomposition->maxima[low] > *maximum) ? decomposition->maxima[low] : *maximum;
+            low++;
+        }
+        if (high & 1)
         {
-            noParent++;
-            noParentIndex = i;
+            high--;
+            *sum += decomposition->sums[high];
+            *maximum = (decomposition->maxima[high] > *maximum) ? decomposition->maxima[high] : *maximum;
         }
+    }
+}
 
+/**
+ * Calculates the sum and the maximum of the weights of the vertices on the path between u and v, climbing
+ * from chain to chain so it takes O(log^2 n) time.
+ * @param tree the tree
+ * @param decomposition the heavy light decomposition of the tree
+ * @param u the first vertex
+ * @param v the second vertex
+ * @param sum holds the sum
+ * @param maximum holds the maximum
+ * @return the lowest common ancestor of u and v
+ */
+int pathAggregates(const Tree *tree, const HeavyLight *decomposition, int u, int v, long long *sum,
+                   long long *maximum)
+{
+    const int *heads = decomposition->heads;
+    const int *depths = decomposition->depths;
+    const int *positions = decomposition->positions;
+    *sum = 0;
+    *maximum = LLONG_MIN;
+    while (heads[u] != heads[v])
+    {
+        if (depths[heads[u]] < depths[heads[v]])
+        {
+            int temp = u;
+            u = v;
+            v = temp;
+        }
+        segmentQuery(decomposition, positions[heads[u]], positions[u], sum, maximum);
+        u = tree->nodes[heads[u]].parentKey;
     }
-    if (noParent == 1)
+    if (depths[u] > depths[v])
     {
-        tree->root = noParentIndex;
-        return VALID_INPUT;
+        int temp = u;
+        u = v;
+        v = temp;
     }
-    else
+    segmentQuery(decomposition, positions[u], positions[v], sum, maximum);
+    return u;
+}
+
+/**
+ * Calculates the weighted distance between u and v, the length of an edge is the weight of its child,
+ * so it is the weight of the path without the weight of the lowest common ancestor.
+ * @param tree the tree
+ * @param decomposition the heavy light decomposition of the tree
+ * @param u the first vertex
+ * @param v the second vertex
+ * @return the distance
+ */
+long long weightedDistance(const Tree *tree, const HeavyLight *decomposition, int u, int v)
+{
+    long long sum, maximum;
+    int ancestor = pathAggregates(tree, decomposition, u, v, &sum, &maximum);
+    return sum - tree->weights[ancestor];
+}
+
+/**
+ * Calculates the weighted diameter, the longest weighted distance, by the longest downward path of every
+ * vertex in reverse BFS order. A path of no edges has length 0, so negative weights are handled too.
+ * @param tree the tree
+ * @param decomposition the heavy light decomposition of the tree, its BFS order is used
+ * @return the diameter
+ */
+long long weightedDiameter(const Tree *tree, HeavyLight *decomposition)
+{
+    long long diameter = 0;
+    long long *downs = decomposition->downs;
+    for (int i = tree->numOfNodes - 1; i >= 0; --i)
     {
-        return NOT_A_TREE;
+        Node *curNode = &tree->nodes[decomposition->order[i]];
+        long long first = 0;
+        long long second = 0;
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            int child = curNode->children[j];
+            long long down = tree->weights[child] + downs[child];
+            if (down > first)
+            {
+                second = first;
+                first = down;
+            }
+            else if (down > second)
+            {
+                second = down;
+            }
+        }
+        downs[curNode->key] = first;
+        diameter = (first + second > diameter) ? first + second : diameter;
     }
+    return diameter;
 }
 
+/**
+ * Builds the heavy light decomposition of the tree: every vertex continues the chain of its parent if it has
+ * the largest subtree among its siblings, the chains take consecutive positions in a segment tree of the
+ * weights. Uses no recursion, the BFS order of the tree is kept for the diameter.
+ * @param tree the tree, with its weights
+ * @param decomposition the heavy light decomposition, its arrays are taken from the arena of the tree
+ */
+void buildHeavyLight(const Tree *tree, HeavyLight *decomposition)
+{
+    int n = tree->numOfNodes;
+    int *order = decomposition->order;
+    int *heavy = decomposition->heavy;
+    // the subtree sizes are kept in positions until the positions are given.
+    int *sizes = decomposition->positions;
+    int tail = 0;
+    decomposition->numOfNodes = n;
+    order[tail++] = tree->root;
+    decomposition->depths[tree->root] = 0;
+    for (int head = 0; head < tail; ++head)
+    {
+        Node *curNode = &tree->nodes[order[head]];
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            decomposition->depths[curNode->children[j]] = decomposition->depths[curNode->key] + 1;
+            order[tail++] = curNode->children[j];
+        }
+    }
+    for (int i = n - 1; i >= 0; --i)
+    {
+        Node *curNode = &tree->nodes[order[i]];
+        sizes[curNode->key] = 1;
+        heavy[curNode->key] = DEFAULT_PARENT;
+        for (int j = 0; j < curNode->numOfChildren; ++j)
+        {
+            int child = curNode->children[j];
+            sizes[curNode->key] += sizes[child];
+            if (heavy[curNode->key] == DEFAULT_PARENT || sizes[child] > sizes[heavy[curNode->key]])
+            {
+                heavy[curNode->key] = child;
+            }
+        }
+    }
+    int position = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        int key = order[i];
+        int parentKey = tree->nodes[key].parentKey;
+        if (parentKey != DEFAULT_PARENT && heavy[parentKey] == key)
+        {
+            continue;
+        }
+        // a light vertex starts a chain, which takes the next positions down to its end.
+        for (int next = key; next != DEFAULT_PARENT; next = heavy[next])
+        {
+            decomposition->heads[next] = key;
+            decomposition->positions[next] = position++;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        decomposition->sums[decomposition->positions[i] + n] = tree->weights[i];
+        decomposition->maxima[decomposition->positions[i] + n] = tree->weights[i];
+    }
+    for (int i = n - 1; i >= 1; --i)
+    {
+        decomposition->sums[i] = decomposition->sums[2 * i] + decomposition->sums[2 * i + 1];
+        decomposition->maxima[i] = (decomposition->maxima[2 * i] > decomposition->maxima[2 * i + 1])
+                                   ? decomposition->maxima[2 * i] : decomposition->maxima[2 * i + 1];
+    }
+    decomposition->diameter = weightedDiameter(tree, decomposition);
+    decomposition->diameterIsValid = 1;
+}
 
 /**
- * Prints the information about the tree
- * @param tree the tree that needs to be printed
+ * Prints the weighted diameter of the tree and the weighted distance between the given vertices.
+ * @param tree the tree
+ * @param decomposition the heavy light decomposition of the tree
  * @param uKey the first of the vertices given as input
  * @param vKey the second of the vertices given as input
  */
-void treePrinter(Tree *tree, int uKey, int vKey)
+void weightsPrinter(const Tree *tree, const HeavyLight *decomposition, int uKey, int vKey)
 {
-    printf("Root Vertex: %d\n", tree->root);
-    printf("Vertices Count: %d\n", tree->numOfNodes);
-    printf("Edges Count: %d\n", tree->numOfEdges);
-    printf("Length of Minimal Branch: %d\n", tree->minBranch);
-    printf("Length of Maximal Branch: %d\n", tree->maxBranch);
-    printf("Diameter Length: %d\n", tree->diameter);
-    printf("Shortest Path Between %d and %d:", uKey, vKey);
-    for (int i = tree->pathLen - 1; i >= 0; --i)
+    printf("Weighted Diameter Length: %lld\n", decomposition->diameter);
+    printf("Weighted Distance Between %d and %d: %lld\n", uKey, vKey,
+           weightedDistance(tree, decomposition, uKey, vKey));
+}
+
+/**
+ * Runs the commands of a weights script on the tree: "sum u v" and "max u v" print the sum and the maximum of
+ * the weights on the path between u and v, "distance u v" prints their weighted distance, "set v w" sets the
+ * weight of v to w and "diameter" prints the weighted diameter. The path commands and the updates take
+ * O(log^2 n) time, the diameter is calculated again only after an update. A command that can't be done is
+ * reported and skipped.
+ * @param tree the analyzed tree, with its weights
+ * @param decomposition the heavy light decomposition of the tree
+ * @param scriptPath the path of the script, "-" for the standard input
+ * @return VALID_INPUT enum if the script was run and INVALID_INPUT enum if it couldn't be opened
+ */
+enum validityType runWeightsScript(Tree *tree, HeavyLight *decomposition, const char *scriptPath)
+{
+    char line[COMMAND_LEN];
+    char command[COMMAND_LEN];
+    FILE *script = (strcmp(scriptPath, STDIN_PATH) == 0) ? stdin : fopen(scriptPath, "r");
+    if (script == NULL)
     {
-        printf(" %d", tree->path[i]);
+        return INVALID_INPUT;
     }
-    printf("\n");
+    while (fgets(line, COMMAND_LEN, script) != NULL)
+    {
+        int u = 0;
+        int v = 0;
+        int numOfFields = sscanf(line, COMMAND_FORMAT, command, &u, &v);
+        if (numOfFields <= 0)
+        {
+            continue;
+        }
+        long long sum, maximum;
+        int uInRange = u >= 0 && u < tree->numOfNodes;
+        int inRange = uInRange && v >= 0 && v < tree->numOfNodes;
+        if (numOfFields == 3 && inRange && strcmp(command, SUM_COMMAND) == 0)
+        {
+            pathAggregates(tree, decomposition, u, v, &sum, &maximum);
+            printf("Path Sum Between %d and %d: %lld\n", u, v, sum);
+        }
+        else if (numOfFields == 3 && inRange && strcmp(command, MAX_COMMAND) == 0)
+        {
+            pathAggregates(tree, decomposition, u, v, &sum, &maximum);
+            printf("Path Max Between %d and %d: %lld\n", u, v, maximum);
+        }
+        else if (numOfFields == 3 && inRange && strcmp(command, DISTANCE_COMMAND) == 0)
+        {
+            printf("Weighted Distance Between %d and %d: %lld\n", u, v, weightedDistance(tree, decomposition, u, v));
+        }
+        else if (numOfFields == 3 && uInRange && strcmp(command, SET_COMMAND) == 0)
+        {
+            tree->weights[u] = v;
+            setPathWeight(decomposition, u, v);
+            decomposition->diameterIsValid = 0;
+        }
+        else if (numOfFields == 1 && strcmp(command, DIAMETER_COMMAND) == 0)
+        {
+            if (!decomposition->diameterIsValid)
+            {
+                decomposition->diameter = weightedDiameter(tree, decomposition);
+                decomposition->diameterIsValid = 1;
+            }
+            printf("Weighted Diameter Length: %lld\n", decomposition->diameter);
+        }
+        else
+        {
+            fprintf(stderr, INVALID_COMMAND_MSG, line);
+        }
+    }
+    if (script != stdin)
+    {
+        fclose(script);
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Finds the input format of the given name: children, edges, parents, edges-bin or parents-bin.
+ * @param name the name of the format
+ * @return the format, UNKNOWN_FORMAT if there is no such format
+ */
+enum inputFormat formatFromName(const char *name)
+{
+    const char *names[] = {"children", "edges", "parents", "edges-bin", "parents-bin"};
+    for (int format = CHILD_LIST_FORMAT; format < UNKNOWN_FORMAT; ++format)
+    {
+        if (strcmp(name, names[format]) == 0)
+        {
+            return (enum inputFormat)format;
+        }
+    }
+    return UNKNOWN_FORMAT;
+}
+
+/**
+ * Prints the problem of an option and the usage of the program.
+ * @param format the message of the problem, with a %s for the option
+ * @param option the option
+ * @return -1, the result of parseOptions for a bad option
+ */
+static int optionProblem(const char *format, const char *option)
+{
+    fprintf(stderr, format, option);
+    fprintf(stderr, WRONG_NUM_OF_ARGS_MSG);
+    return -1;
+}
+
+/**
+ * Reads the options that are given before the graph file path. An unknown option or an option with a missing
+ * or bad value is reported, and so are the succinct, the batch and the out of core modes with an option that
+ * they would ignore.
+ * @param argc number of given arguments
+ * @param argv the given arguments as an input
+ * @param options holds the options
+ * @return the number of arguments the options took, -1 if an option is not valid
+ */
+int parseOptions(int argc, char *argv[], Options *options)
+{
+    int i = 1;
+    int budget;
+    // the options that take a value, which may be any string.
+    const char *valueOptions[] = {SAVE_CACHE_OPTION, FORMAT_OPTION, ECCENTRICITIES_OPTION,
+                                  BINARY_ECCENTRICITIES_OPTION, WEIGHT_QUERIES_OPTION, BATCH_OPTION,
+                                  DYNAMIC_OPTION, OUT_OF_CORE_OPTION, MEMORY_BUDGET_OPTION, THREADS_OPTION};
+    options->saveCachePath = NULL;
+    options->loadCache = 0;
+    options->numOfThreads = 0;
+    options->withMetrics = 0;
+    options->dynamicScriptPath = NULL;
+    options->batchManifestPath = NULL;
+    options->inputFormat = CHILD_LIST_FORMAT;
+    options->withWeights = 0;
+    options->weightScriptPath = NULL;
+    options->withCanonicalHash = 0;
+    options->eccentricitiesPath = NULL;
+    options->binaryEccentricities = 0;
+    options->withProfile = 0;
+    options->withSuccinct = 0;
+    options->outOfCoreDirectory = NULL;
+    options->memoryBudget = DEFAULT_MEMORY_BUDGET_MB;
+    while (i < argc && strncmp(argv[i], "--", 2) == 0)
+    {
+        for (size_t j = 0; j < sizeof(valueOptions) / sizeof(valueOptions[0]); ++j)
+        {
+            if (strcmp(argv[i], valueOptions[j]) == 0 && i + 1 >= argc)
+            {
+                return optionProblem(BAD_OPTION_VALUE_MSG, argv[i]);
+            }
+        }
+        if (strcmp(argv[i], SAVE_CACHE_OPTION) == 0)
+        {
+            options->saveCachePath = argv[++i];
+        }
+        else if (strcmp(argv[i], LOAD_CACHE_OPTION) == 0)
+        {
+            options->loadCache = 1;
+        }
+        else if (strcmp(argv[i], METRICS_OPTION) == 0)
+        {
+            options->withMetrics = 1;
+        }
+        else if (strcmp(argv[i], FORMAT_OPTION) == 0)
+        {
+            if ((options->inputFormat = formatFromName(argv[i + 1])) == UNKNOWN_FORMAT)
+            {
+                return optionProblem(BAD_OPTION_VALUE_MSG, argv[i]);
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], PROFILE_OPTION) == 0)
+        {
+            options->withProfile = 1;
+        }
+        else if (strcmp(argv[i], SUCCINCT_OPTION) == 0)
+        {
+            options->withSuccinct = 1;
+        }
+        else if (strcmp(argv[i], CANONICAL_HASH_OPTION) == 0)
+        {
+            options->withCanonicalHash = 1;
+        }
+        else if ((strcmp(argv[i], ECCENTRICITIES_OPTION) == 0 ||
+                  strcmp(argv[i], BINARY_ECCENTRICITIES_OPTION) == 0))
+        {
+            options->binaryEccentricities = strcmp(argv[i], BINARY_ECCENTRICITIES_OPTION) == 0;
+            options->eccentricitiesPath = argv[++i];
+        }
+        else if (strcmp(argv[i], WEIGHTED_OPTION) == 0)
+        {
+            options->withWeights = 1;
+        }
+        else if (strcmp(argv[i], WEIGHT_QUERIES_OPTION) == 0)
+        {
+            options->withWeights = 1;
+            options->weightScriptPath = argv[++i];
+        }
+        else if (strcmp(argv[i], BATCH_OPTION) == 0)
+        {
+            options->batchManifestPath = argv[++i];
+        }
+        else if (strcmp(argv[i], DYNAMIC_OPTION) == 0)
+        {
+            options->dynamicScriptPath = argv[++i];
+        }
+        else if (strcmp(argv[i], OUT_OF_CORE_OPTION) == 0)
+        {
+            options->outOfCoreDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], MEMORY_BUDGET_OPTION) == 0)
+        {
+            if (processN(argv[i + 1], (int)strlen(argv[i + 1]), &budget) != VALID_INPUT || budget <= 0)
+            {
+                return optionProblem(BAD_OPTION_VALUE_MSG, argv[i]);
+            }
+            options->memoryBudget = budget;
+            i++;
+        }
+        else if (strcmp(argv[i], THREADS_OPTION) == 0)
+        {
+            if (processN(argv[i + 1], (int)strlen(argv[i + 1]), &options->numOfThreads) != VALID_INPUT ||
+                options->numOfThreads < 1 || options->numOfThreads > MAX_THREADS)
+            {
+                return optionProblem(BAD_OPTION_VALUE_MSG, argv[i]);
+            }
+            i++;
+        }
+        else
+        {
+            return optionProblem(UNKNOWN_OPTION_MSG, argv[i]);
+        }
+        i++;
+    }
+    // the succinct mode prints the plain summary only, from the form that is built while parsing.
+    if (options->withSuccinct && (options->saveCachePath != NULL || options->loadCache || options->withMetrics ||
+                                  options->dynamicScriptPath != NULL || options->batchManifestPath != NULL ||
+                                  options->withWeights || options->withCanonicalHash ||
+                                  options->eccentricitiesPath != NULL || options->withProfile ||
+                                  options->outOfCoreDirectory != NULL))
+    {
+        return optionProblem(CONFLICTING_OPTION_MSG, SUCCINCT_OPTION);
+    }
+    // the rows of a batch are analyzed with the format and the canonical hash only.
+    if (options->batchManifestPath != NULL && (options->saveCachePath != NULL || options->loadCache ||
+                                               options->withMetrics || options->dynamicScriptPath != NULL ||
+                                               options->withWeights || options->eccentricitiesPath != NULL ||
+                                               options->withProfile || options->outOfCoreDirectory != NULL))
+    {
+        return optionProblem(CONFLICTING_OPTION_MSG, BATCH_OPTION);
+    }
+    // the out of core mode reads a child list and prints the plain summary, with a single thread.
+    if (options->outOfCoreDirectory != NULL && (options->saveCachePath != NULL || options->loadCache ||
+                                                options->withMetrics || options->dynamicScriptPath != NULL ||
+                                                options->withWeights || options->withCanonicalHash ||
+                                                options->eccentricitiesPath != NULL || options->withProfile ||
+                                                options->numOfThreads != 0 ||
+                                                options->inputFormat != CHILD_LIST_FORMAT))
+    {
+        return optionProblem(CONFLICTING_OPTION_MSG, OUT_OF_CORE_OPTION);
+    }
+    return i - 1;
 }
 
+#ifndef TREE_ANALYZER_NO_MAIN
 /**
  * The main function that runs that program. Closes the program if the number of the given arguments given as input
  * is incorrect and if there is a problem with the input or the given graph is not a tree.
- * Prints the information about the tree that was created in the program.
+ * Prints the information about the tree that was created in the program, optionally saving the validated tree
+ * to a cache file or loading it from one, and runs a script of links, cuts and queries on it in the
+ * dynamic mode. In the succinct mode the tree is analyzed in its balanced parentheses form. The eccentricities
+ * of all the vertices can be written to a column, with the radius printed.
+ * A weighted tree also gets its weighted diameter and distance, and path queries and updates
+ * from a script. In the batch mode the arguments of every analysis are read from a manifest instead.
  * @param argc number of given arguments
  * @param argv the given arguments as an input
  * @return 1 if the program failed and 0 otherwise
  */
 int main(int argc, char* argv[])
 {
+    Options options;
+    int numOfOptions = parseOptions(argc, argv, &options);
+    if (numOfOptions < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    argc -= numOfOptions;
+    argv += numOfOptions;
+    if (options.batchManifestPath != NULL)
+    {
+        if (argc != 1) // the arguments of the analyses are in the manifest
+        {
+            fprintf(stderr, WRONG_NUM_OF_ARGS_MSG);
+            return EXIT_FAILURE;
+        }
+        return runBatch(options.batchManifestPath, &options);
+    }
     if (argc-1 != NUM_ARGS) // entered wrong amount of arguments
     {
         fprintf(stderr, WRONG_NUM_OF_ARGS_MSG);
@@ -602,28 +3296,114 @@ int main(int argc, char* argv[])
     }
     FILE* fp;
     fp = fopen(argv[1], "r");
+    if (options.outOfCoreDirectory != NULL || options.withSuccinct)
+    {
+        Tree emptyTree;
+        initiateTree(&emptyTree);
+        enum validityType modeResult = options.withSuccinct ? succinctAnalysis(argv, fp, &options)
+                                                            : outOfCoreAnalysis(argv, fp, &options);
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        return exitPro(modeResult, &emptyTree);
+    }
     int u, v, n;
     Tree myTree;
+    Profile profile;
     initiateTree(&myTree);
-    enum validityType processResult = inputValidityCheck(argv, &n, &u, &v, &myTree, fp);
-    if (exitPro(processResult, &myTree) == EXIT_FAILURE)
+    if (options.withProfile)
+    {
+        startProfile(&profile);
+        myTree.profile = &profile;
+    }
+    myTree.numOfThreads = (options.numOfThreads > 0) ? options.numOfThreads : 1;
+    myTree.withMetrics = options.withMetrics;
+    myTree.inputFormat = options.inputFormat;
+    myTree.withWeights = options.withWeights;
+    myTree.withCanonicalHash = options.withCanonicalHash;
+    myTree.withEccentricities = options.eccentricitiesPath != NULL;
+    enum validityType processResult = options.loadCache ? loadTreeCache(argv, &n, &u, &v, &myTree, fp)
+                                                        : inputValidityCheck(argv, &n, &u, &v, &myTree, fp);
+    if (fp != NULL)
     {
         fclose(fp);
-        return EXIT_FAILURE;
     }
-    enum validityType findRootResult = findRoot(&myTree);
-    if (isTheGraphTree(&myTree) == NOT_A_TREE)
+    profilePhase(myTree.profile, PARSE_PHASE);
+    if (exitPro(processResult, &myTree) == EXIT_FAILURE)
     {
-        exitPro(NOT_A_TREE, &myTree);
         return EXIT_FAILURE;
     }
-    if (exitPro(findRootResult, &myTree) == EXIT_FAILURE)
+    if (!options.loadCache)
+    {
+        branchLengths(&myTree);
+    }
+    profilePhase(myTree.profile, BRANCHES_PHASE);
+    if (options.saveCachePath != NULL &&
+        exitPro(saveTreeCache(&myTree, options.saveCachePath), &myTree) == EXIT_FAILURE)
     {
-        fclose(fp);
         return EXIT_FAILURE;
     }
     diameterAndPath(&myTree, &myTree.nodes[u], &myTree.nodes[v]);
-    treePrinter(&myTree, u, v);
+    profilePhase(myTree.profile, DIAMETER_PHASE);
+    treePrinter(&myTree, u, v, stdout);
+    profilePhase(myTree.profile, PRINT_PHASE);
+    if (myTree.withMetrics || myTree.withCanonicalHash)
+    {
+        treeCenters(&myTree);
+    }
+    if (myTree.withMetrics)
+    {
+        structuralMetrics(&myTree);
+        metricsPrinter(&myTree);
+    }
+    if (myTree.withCanonicalHash)
+    {
+        printf(CANONICAL_HASH_FORMAT, canonicalHash(&myTree));
+    }
+    if (myTree.withEccentricities)
+    {
+        treeEccentricities(&myTree);
+        printf(RADIUS_FORMAT, myTree.radius);
+        if (exitPro(eccentricitiesWriter(&myTree, options.eccentricitiesPath, options.binaryEccentricities),
+                    &myTree) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (myTree.withWeights)
+    {
+        buildHeavyLight(&myTree, myTree.heavyLight);
+        weightsPrinter(&myTree, myTree.heavyLight, u, v);
+        if (options.weightScriptPath != NULL &&
+            runWeightsScript(&myTree, myTree.heavyLight, options.weightScriptPath) != VALID_INPUT)
+        {
+            fprintf(stderr, SCRIPT_OPEN_FAILED_MSG);
+            freeTree(&myTree);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.dynamicScriptPath != NULL)
+    {
+        enum validityType dynamicResult = runDynamicScript(&myTree, options.dynamicScriptPath);
+        if (dynamicResult == INVALID_INPUT)
+        {
+            fprintf(stderr, SCRIPT_OPEN_FAILED_MSG);
+            freeTree(&myTree);
+            return EXIT_FAILURE;
+        }
+        if (exitPro(dynamicResult, &myTree) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
     freeTree(&myTree);
+    if (options.withProfile)
+    {
+        // the workers of the parallel BFS are joined by now, so their cache misses are counted.
+        profilePhase(&profile, EXTRAS_PHASE);
+        profilePrinter(&profile);
+    }
     return EXIT_SUCCESS;
 }
+#endif
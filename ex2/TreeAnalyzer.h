@@ -0,0 +1,183 @@
+/**
+ * The types and functions of TreeAnalyzer that are shared by the files of its modes.
+ * Build: gcc -O2 -std=c99 TreeAnalyzer.c TreeOutOfCore.c TreeDynamic.c TreeSuccinct.c -o TreeAnalyzer -lpthread -lm
+ */
+#ifndef TREE_ANALYZER_H
+#define TREE_ANALYZER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define DEFAULT_PARENT -1
+#define KEY_BYTES 4
+#define MAX_CENTERS 2
+#define STDIN_PATH "-"
+#define COMMAND_LEN 128
+#define COMMAND_FORMAT "%127s %d %d"
+#define DIAMETER_COMMAND "diameter"
+#define INVALID_COMMAND_MSG "Invalid command: %s"
+
+enum validityType
+        {
+    INVALID_INPUT,
+    NOT_A_TREE,
+    BAD_MEMORY_ALLOCATION,
+    FILE_WRITE_FAILED,
+    VALID_INPUT
+        };
+
+/**
+ * The formats of the graph file. A child list holds a line of children for every vertex, an edge list a
+ * "parent child" line for every edge and a parent array the parent of every vertex, "-1" or "-" for the root.
+ * The binary formats hold the same numbers as 32 bit little endian integers, with no separators.
+ */
+enum inputFormat
+        {
+    CHILD_LIST_FORMAT,
+    EDGE_LIST_FORMAT,
+    PARENT_ARRAY_FORMAT,
+    BINARY_EDGE_LIST_FORMAT,
+    BINARY_PARENT_ARRAY_FORMAT,
+    UNKNOWN_FORMAT
+        };
+
+/**
+ * structure that represents a Node in the graph. Each node has a different key,
+ * each nodes has children if it has ones, and each has a parent and parent key, unless he is a root.
+ */
+typedef struct Node
+{
+    int key;
+    int numOfChildren;
+    int parentKey;
+    int distance;
+    struct Node *previus;
+    int *children;
+    struct Node *parent;
+} Node;
+
+/**
+ * structure that represents one block of memory that all the memory of the analysis is taken from.
+ * The block is sized once from the number of vertices and released at once.
+ */
+typedef struct Arena
+{
+    char *memory;
+    size_t capacity;
+    size_t used;
+} Arena;
+
+/**
+ * structure that represents a tree graph. Each Tree has a root, the nodes in the tree,
+ * the number of nodes in that tree and the depth of the tree.
+ */
+typedef struct Tree
+{
+    int numOfEdges;
+    int numOfNodes;
+    int root;
+    int maxBranch;
+    int minBranch;
+    int diameter;
+    int pathLen;
+    int numOfThreads;
+    int withMetrics;
+    enum inputFormat inputFormat;
+    int withWeights;
+    int withCanonicalHash;
+    int withEccentricities;
+    int radius;
+    int numOfCentroids;
+    int centroids[MAX_CENTERS];
+    int numOfCenters;
+    int centers[MAX_CENTERS];
+    long long childrenKeysSum;
+    int *path;
+    int *edges;
+    int *sets;
+    int *traversal;
+    int *subtreeSizes;
+    int *heights;
+    int *weights;
+    struct HeavyLight *heavyLight;
+    unsigned long long *subtreeHashes;
+    unsigned long long *hashScratch;
+    int *downFirst;
+    int *downSecond;
+    int *eccentricities;
+    struct Profile *profile;
+    struct BFSContext *bfs;
+    Node *nodes;
+    Arena arena;
+} Tree;
+
+/**
+ * structure that represents the graph file content, either memory mapped or read into a buffer
+ * when the file can not be mapped (a pipe for example).
+ */
+typedef struct GraphFile
+{
+    const char *data;
+    size_t length;
+    int isMapped;
+} GraphFile;
+
+/**
+ * structure that holds the options given to the program before the graph file path.
+ */
+typedef struct Options
+{
+    const char *saveCachePath;
+    int loadCache;
+    int numOfThreads;
+    int withMetrics;
+    const char *dynamicScriptPath;
+    const char *batchManifestPath;
+    enum inputFormat inputFormat;
+    int withWeights;
+    const char *weightScriptPath;
+    int withCanonicalHash;
+    const char *eccentricitiesPath;
+    int binaryEccentricities;
+    int withProfile;
+    int withSuccinct;
+    const char *outOfCoreDirectory;
+    long long memoryBudget;
+} Options;
+
+/**
+ * Checks if the given char separates two numbers in a line of the graph file.
+ * @param c the char to check
+ * @return 1 if it is a delimiter and 0 otherwise
+ */
+static inline int isDelimiter(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// the tree, the parser and the printers of TreeAnalyzer.c, shared with the modes that are kept in their own files.
+void *arenaAlloc(Arena *arena, size_t size);
+void initiateTree(Tree *tree);
+void freeTree(Tree *tree);
+void profileHeap(Tree *tree, size_t bytes);
+enum validityType processN(const char *value, int length, int *nPointer);
+enum validityType parseNumber(const char **cursor, const char *end, long limit, int *nPointer);
+enum validityType parseKeysLine(const char *line, const char *lineEnd, int n, int numOfKeys, int *keys);
+enum validityType scanChildren(const char *line, const char *lineEnd, int numOfNodes, int *children,
+                               int capacity, int *numOfChildren);
+int readLittleEndian(const char *bytes);
+enum validityType mapGraphFile(FILE *fileP, GraphFile *graphFile);
+void unmapGraphFile(GraphFile *graphFile);
+void treeSummaryPrinter(Tree *tree, FILE *out);
+void treePrinter(Tree *tree, int uKey, int vKey, FILE *out);
+
+// the out of core mode, in TreeOutOfCore.c.
+enum validityType outOfCoreAnalysis(char **argv, FILE *fileP, const Options *options);
+
+// the dynamic mode, in TreeDynamic.c.
+enum validityType runDynamicScript(Tree *tree, const char *scriptPath);
+
+// the succinct mode, in TreeSuccinct.c.
+enum validityType succinctAnalysis(char **argv, FILE *fileP, const Options *options);
+
+#endif
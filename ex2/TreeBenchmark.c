@@ -0,0 +1,189 @@
+/**
+ * Times the phases of TreeAnalyzer on generated trees of growing sizes and reports how every phase scales.
+ * Build: gcc -O2 -std=c99 TreeBenchmark.c TreeOutOfCore.c TreeDynamic.c TreeSuccinct.c -o TreeBenchmark -lpthread -lm
+ */
+#define TREE_ANALYZER_NO_MAIN
+#define TREE_GENERATOR_NO_MAIN
+#include "TreeAnalyzer.c"
+#include "TreeGenerator.c"
+#include <math.h>
+#include <time.h>
+
+#define BENCHMARK_USAGE_MSG "Usage: TreeBenchmark [Max Number Of Vertices] [Repetitions]\n"
+#define BENCHMARK_MIN_SIZE 1000
+#define BENCHMARK_DEFAULT_MAX_SIZE 1000000
+#define BENCHMARK_MAX_SIZE 100000000
+#define BENCHMARK_DEFAULT_REPETITIONS 3
+#define BENCHMARK_SIZE_STEP 10
+#define BENCHMARK_MAX_STEPS 6
+#define BENCHMARK_ARITY 3
+#define BENCHMARK_SEED 12345
+#define BENCHMARK_KEY_LEN 16
+#define NUM_OF_PHASES 3
+#define NANOS_IN_SECOND 1e9
+
+/**
+ * Returns the time of a monotonic clock.
+ * @return the time in seconds
+ */
+static double nowSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / NANOS_IN_SECOND;
+}
+
+/**
+ * Runs the analysis of the tree in the given file and times its phases: the parsing, which also finds the
+ * root and checks the graph is a tree, the branch lengths, and the diameter and path.
+ * @param graphFile the file of the tree
+ * @param n the number of vertices of the tree
+ * @param times holds the time of every phase in seconds
+ * @return VALID_INPUT enum if the tree was analyzed, the problem otherwise
+ */
+enum validityType timePhases(FILE *graphFile, int n, double *times)
+{
+    char vKey[BENCHMARK_KEY_LEN];
+    char uKey[] = "0";
+    char *argv[NUM_ARGS + 1] = {NULL, NULL, uKey, vKey};
+    int parsedN, u, v;
+    Tree tree;
+    snprintf(vKey, sizeof(vKey), "%d", n - 1);
+    initiateTree(&tree);
+    rewind(graphFile);
+    double start = nowSeconds();
+    enum validityType result = inputValidityCheck(argv, &parsedN, &u, &v, &tree, graphFile);
+    times[0] = nowSeconds() - start;
+    if (result != VALID_INPUT)
+    {
+        freeTree(&tree);
+        return result;
+    }
+    start = nowSeconds();
+    branchLengths(&tree);
+    times[1] = nowSeconds() - start;
+    start = nowSeconds();
+    diameterAndPath(&tree, &tree.nodes[u], &tree.nodes[v]);
+    times[2] = nowSeconds() - start;
+    freeTree(&tree);
+    return VALID_INPUT;
+}
+
+/**
+ * Calculates the scaling exponent of a phase, the slope of the least squares line of log(time) by log(n).
+ * @param sizes the sizes the phase was timed at
+ * @param times the times of the phase
+ * @param numOfSizes the number of sizes
+ * @return the exponent, or NAN if there are not enough timed sizes
+ */
+double scalingExponent(const int *sizes, const double *times, int numOfSizes)
+{
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    int count = 0;
+    for (int i = 0; i < numOfSizes; ++i)
+    {
+        if (times[i] > 0)
+        {
+            double x = log((double)sizes[i]);
+            double y = log(times[i]);
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+            count++;
+        }
+    }
+    double denominator = count * sumXX - sumX * sumX;
+    if (count < 2 || denominator == 0)
+    {
+        return NAN;
+    }
+    return (count * sumXY - sumX * sumY) / denominator;
+}
+
+/**
+ * Times every phase on every shape at the sizes 10^3, 10^4, ... up to the given size, keeping the best of the
+ * repetitions, and prints the times and the scaling exponent of every phase.
+ * @param maxSize the largest number of vertices
+ * @param repetitions the number of times every size is timed
+ * @return EXIT_SUCCESS if all the trees were analyzed and EXIT_FAILURE otherwise
+ */
+int runBenchmark(int maxSize, int repetitions)
+{
+    const char *shapeNames[] = {"path", "star", "kary", "caterpillar", "prufer"};
+    const char *phaseNames[NUM_OF_PHASES] = {"parse", "branches", "diameter"};
+    int sizes[BENCHMARK_MAX_STEPS];
+    double times[NUM_OF_PHASES][BENCHMARK_MAX_STEPS];
+    int numOfSizes = 0;
+    for (long long size = BENCHMARK_MIN_SIZE; size <= maxSize && numOfSizes < BENCHMARK_MAX_STEPS;
+         size *= BENCHMARK_SIZE_STEP)
+    {
+        sizes[numOfSizes++] = (int)size;
+    }
+    printf("%-12s %10s %12s %12s %12s\n", "Shape", "Vertices", phaseNames[0], phaseNames[1], phaseNames[2]);
+    for (int shape = PATH_SHAPE; shape < UNKNOWN_SHAPE; ++shape)
+    {
+        for (int i = 0; i < numOfSizes; ++i)
+        {
+            FILE *graphFile = tmpfile();
+            if (graphFile == NULL ||
+                generateTree(graphFile, (enum treeShape)shape, sizes[i], BENCHMARK_ARITY, BENCHMARK_SEED) != 0 ||
+                fflush(graphFile) != 0)
+            {
+                fprintf(stderr, FILE_WRITE_FAILED_MSG);
+                return EXIT_FAILURE;
+            }
+            for (int phase = 0; phase < NUM_OF_PHASES; ++phase)
+            {
+                times[phase][i] = INFINITY;
+            }
+            for (int repetition = 0; repetition < repetitions; ++repetition)
+            {
+                double repetitionTimes[NUM_OF_PHASES];
+                enum validityType result = timePhases(graphFile, sizes[i], repetitionTimes);
+                if (result != VALID_INPUT)
+                {
+                    fprintf(stderr, "%s", problemMessage(result));
+                    fclose(graphFile);
+                    return EXIT_FAILURE;
+                }
+                for (int phase = 0; phase < NUM_OF_PHASES; ++phase)
+                {
+                    times[phase][i] = fmin(times[phase][i], repetitionTimes[phase]);
+                }
+            }
+            fclose(graphFile);
+            printf("%-12s %10d %12.6f %12.6f %12.6f\n", shapeNames[shape], sizes[i], times[0][i], times[1][i],
+                   times[2][i]);
+            fflush(stdout);
+        }
+        printf("%-12s %10s", shapeNames[shape], "exponent");
+        for (int phase = 0; phase < NUM_OF_PHASES; ++phase)
+        {
+            printf(" %12.2f", scalingExponent(sizes, times[phase], numOfSizes));
+        }
+        printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Runs the benchmark. An exponent well above 1 for a phase means the phase is no longer linear.
+ * @param argc number of given arguments
+ * @param argv optionally the largest number of vertices and the number of repetitions
+ * @return 1 if the program failed and 0 otherwise
+ */
+int main(int argc, char *argv[])
+{
+    int maxSize = BENCHMARK_DEFAULT_MAX_SIZE;
+    int repetitions = BENCHMARK_DEFAULT_REPETITIONS;
+    if (argc > NUM_ARGS ||
+        (argc > 1 && (processN(argv[1], (int)strlen(argv[1]), &maxSize) != VALID_INPUT ||
+                      maxSize < BENCHMARK_MIN_SIZE || maxSize > BENCHMARK_MAX_SIZE)) ||
+        (argc > 2 && (processN(argv[2], (int)strlen(argv[2]), &repetitions) != VALID_INPUT || repetitions < 1)))
+    {
+        fprintf(stderr, BENCHMARK_USAGE_MSG);
+        return EXIT_FAILURE;
+    }
+    return runBenchmark(maxSize, repetitions);
+}
@@ -0,0 +1,653 @@
+/**
+ * The dynamic mode of TreeAnalyzer: the tree is kept as an Euler tour forest, on which a script of links, cuts
+ * and distance and diameter queries is run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TreeAnalyzer.h"
+
+#define LINK_COMMAND "link"
+#define CUT_COMMAND "cut"
+#define QUERY_COMMAND "query"
+#define NO_TOKEN -1
+#define TOUR_INF (1LL << 50)
+#define TOUR_SEED 2463534242u
+#define NUM_OF_AGGREGATES 5
+#define AGG_MAX 0
+#define AGG_MIN 1
+#define AGG_MAX_LEFT 2
+#define AGG_MAX_RIGHT 3
+#define AGG_BEST 4
+
+/**
+ * structure that represents a token of the Euler tour of a forest, kept in a treap ordered by the place of
+ * the token in the tour. Each token holds the depth it stands for and the aggregates of its subtree:
+ * the largest and smallest depths, the largest D[a] - 2D[b] and -2D[b] + D[c] with a <= b <= c, and best,
+ * the largest D[a] - 2D[b] + D[c], which is the diameter of the tree when taken over all its tour.
+ */
+typedef struct TourToken
+{
+    int left;
+    int right;
+    int parent;
+    int size;
+    unsigned int priority;
+    int active;
+    long long depth;
+    long long lazy;
+    long long maxDepth;
+    long long minDepth;
+    long long maxLeft;
+    long long maxRight;
+    long long best;
+} TourToken;
+
+/**
+ * structure that represents a forest that changes by links and cuts. Node v has the tokens 2v and 2v + 1,
+ * parents holds the parent of every node or DEFAULT_PARENT for the roots. All the arrays are taken from the
+ * arena of the forest.
+ */
+typedef struct EulerTour
+{
+    int numOfNodes;
+    TourToken *tokens;
+    int *parents;
+    int *cartesian;
+    Arena arena;
+} EulerTour;
+
+/**
+ * Returns a pseudo random priority for a node of the Euler tour treap.
+ * @param state the state of the generator
+ * @return the priority
+ */
+static unsigned int nextPriority(unsigned int *state)
+{
+    *state ^= *state << 13u;
+    *state ^= *state >> 17u;
+    *state ^= *state << 5u;
+    return *state;
+}
+
+/**
+ * Returns the size of the given treap, 0 if it is empty.
+ * @param tour the Euler tour forest
+ * @param t the root of the treap
+ * @return the number of tokens in it
+ */
+static int tourSize(const EulerTour *tour, int t)
+{
+    return (t == NO_TOKEN) ? 0 : tour->tokens[t].size;
+}
+
+/**
+ * Adds x to the depths of all the tokens under t. The values of t are updated right away, its children
+ * get the addition when t is pushed.
+ * @param tour the Euler tour forest
+ * @param t the root of the subtree
+ * @param x the addition
+ */
+static void tourAdd(EulerTour *tour, int t, long long x)
+{
+    if (t == NO_TOKEN)
+    {
+        return;
+    }
+    TourToken *token = &tour->tokens[t];
+    token->depth += x;
+    token->maxDepth += x;
+    token->minDepth += x;
+    token->maxLeft -= x;
+    token->maxRight -= x;
+    token->lazy += x;
+}
+
+/**
+ * Passes the pending depth addition of t to its children.
+ * @param tour the Euler tour forest
+ * @param t the token
+ */
+static void tourPush(EulerTour *tour, int t)
+{
+    TourToken *token = &tour->tokens[t];
+    if (token->lazy != 0)
+    {
+        tourAdd(tour, token->left, token->lazy);
+        tourAdd(tour, token->right, token->lazy);
+        token->lazy = 0;
+    }
+}
+
+/**
+ * Combines the aggregates of a part of the tour with the aggregates of the part that follows it.
+ * first and second hold maxDepth, minDepth, maxLeft, maxRight and best, the result is written to first.
+ * @param first the aggregates of the first part
+ * @param second the aggregates of the second part
+ */
+static void combineAggregates(long long *first, const long long *second)
+{
+    long long best = first[AGG_BEST];
+    best = (second[AGG_BEST] > best) ? second[AGG_BEST] : best;
+    best = (first[AGG_MAX_LEFT] + second[AGG_MAX] > best) ? first[AGG_MAX_LEFT] + second[AGG_MAX] : best;
+    best = (first[AGG_MAX] + second[AGG_MAX_RIGHT] > best) ? first[AGG_MAX] + second[AGG_MAX_RIGHT] : best;
+    long long maxLeft = (first[AGG_MAX_LEFT] > second[AGG_MAX_LEFT]) ? first[AGG_MAX_LEFT] : second[AGG_MAX_LEFT];
+    if (first[AGG_MAX] - 2 * second[AGG_MIN] > maxLeft)
+    {
+        maxLeft = first[AGG_MAX] - 2 * second[AGG_MIN];
+    }
+    long long maxRight = (first[AGG_MAX_RIGHT] > second[AGG_MAX_RIGHT]) ? first[AGG_MAX_RIGHT]
+                                                                        : second[AGG_MAX_RIGHT];
+    if (second[AGG_MAX] - 2 * first[AGG_MIN] > maxRight)
+    {
+        maxRight = second[AGG_MAX] - 2 * first[AGG_MIN];
+    }
+    first[AGG_MAX] = (first[AGG_MAX] > second[AGG_MAX]) ? first[AGG_MAX] : second[AGG_MAX];
+    first[AGG_MIN] = (first[AGG_MIN] < second[AGG_MIN]) ? first[AGG_MIN] : second[AGG_MIN];
+    first[AGG_MAX_LEFT] = maxLeft;
+    first[AGG_MAX_RIGHT] = maxRight;
+    first[AGG_BEST] = best;
+}
+
+/**
+ * Reads the aggregates of the subtree of t, or the aggregates of an empty part if t is NO_TOKEN.
+ * @param tour the Euler tour forest
+ * @param t the root of the subtree
+ * @param aggregates holds the aggregates
+ */
+static void readAggregates(const EulerTour *tour, int t, long long *aggregates)
+{
+    if (t == NO_TOKEN)
+    {
+        aggregates[AGG_MAX] = -TOUR_INF;
+        aggregates[AGG_MIN] = TOUR_INF;
+        aggregates[AGG_MAX_LEFT] = -TOUR_INF;
+        aggregates[AGG_MAX_RIGHT] = -TOUR_INF;
+        aggregates[AGG_BEST] = -TOUR_INF;
+        return;
+    }
+    const TourToken *token = &tour->tokens[t];
+    aggregates[AGG_MAX] = token->maxDepth;
+    aggregates[AGG_MIN] = token->minDepth;
+    aggregates[AGG_MAX_LEFT] = token->maxLeft;
+    aggregates[AGG_MAX_RIGHT] = token->maxRight;
+    aggregates[AGG_BEST] = token->best;
+}
+
+/**
+ * Recalculates the size and the aggregates of t from its children and its own token. An inactive token
+ * (the closing token of the root of a tree) stands for no node and is left out of the aggregates.
+ * @param tour the Euler tour forest
+ * @param t the token
+ */
+static void tourPull(EulerTour *tour, int t)
+{
+    TourToken *token = &tour->tokens[t];
+    long long aggregates[NUM_OF_AGGREGATES];
+    long long own[NUM_OF_AGGREGATES];
+    readAggregates(tour, token->left, aggregates);
+    readAggregates(tour, NO_TOKEN, own);
+    if (token->active)
+    {
+        own[AGG_MAX] = token->depth;
+        own[AGG_MIN] = token->depth;
+        own[AGG_MAX_LEFT] = -token->depth;
+        own[AGG_MAX_RIGHT] = -token->depth;
+        own[AGG_BEST] = 0;
+    }
+    combineAggregates(aggregates, own);
+    readAggregates(tour, token->right, own);
+    combineAggregates(aggregates, own);
+    token->size = 1 + tourSize(tour, token->left) + tourSize(tour, token->right);
+    token->maxDepth = aggregates[AGG_MAX];
+    token->minDepth = aggregates[AGG_MIN];
+    token->maxLeft = aggregates[AGG_MAX_LEFT];
+    token->maxRight = aggregates[AGG_MAX_RIGHT];
+    token->best = aggregates[AGG_BEST];
+}
+
+/**
+ * Merges two treaps, all the tokens of a come before the tokens of b.
+ * @param tour the Euler tour forest
+ * @param a the first treap
+ * @param b the second treap
+ * @return the root of the merged treap
+ */
+static int tourMerge(EulerTour *tour, int a, int b)
+{
+    int root = NO_TOKEN;
+    int *link = &root;
+    int parent = NO_TOKEN;
+    // walks down the right spine of a and the left spine of b, attaching the higher priority each time.
+    while (a != NO_TOKEN && b != NO_TOKEN)
+    {
+        if (tour->tokens[a].priority > tour->tokens[b].priority)
+        {
+            tourPush(tour, a);
+            *link = a;
+            tour->tokens[a].parent = parent;
+            parent = a;
+            link = &tour->tokens[a].right;
+            a = tour->tokens[a].right;
+        }
+        else
+        {
+            tourPush(tour, b);
+            *link = b;
+            tour->tokens[b].parent = parent;
+            parent = b;
+            link = &tour->tokens[b].left;
+            b = tour->tokens[b].left;
+        }
+    }
+    *link = (a != NO_TOKEN) ? a : b;
+    if (*link != NO_TOKEN)
+    {
+        tour->tokens[*link].parent = parent;
+    }
+    for (; parent != NO_TOKEN; parent = tour->tokens[parent].parent)
+    {
+        tourPull(tour, parent);
+    }
+    return root;
+}
+
+/**
+ * Splits a treap to its first k tokens and the rest.
+ * @param tour the Euler tour forest
+ * @param t the treap
+ * @param k the number of tokens in the first part
+ * @param first holds the root of the first part
+ * @param second holds the root of the second part
+ */
+static void tourSplit(EulerTour *tour, int t, int k, int *first, int *second)
+{
+    int *firstLink = first;
+    int *secondLink = second;
+    int firstParent = NO_TOKEN;
+    int secondParent = NO_TOKEN;
+    int lastFirst = NO_TOKEN;
+    int lastSecond = NO_TOKEN;
+    while (t != NO_TOKEN)
+    {
+        tourPush(tour, t);
+        TourToken *token = &tour->tokens[t];
+        if (tourSize(tour, token->left) < k)
+        {
+            k -= tourSize(tour, token->left) + 1;
+            *firstLink = t;
+            token->parent = firstParent;
+            firstParent = t;
+            lastFirst = t;
+            firstLink = &token->right;
+            t = token->right;
+        }
+        else
+        {
+            *secondLink = t;
+            token->parent = secondParent;
+            secondParent = t;
+            lastSecond = t;
+            secondLink = &token->left;
+            t = token->left;
+        }
+    }
+    *firstLink = NO_TOKEN;
+    *secondLink = NO_TOKEN;
+    for (; lastFirst != NO_TOKEN; lastFirst = tour->tokens[lastFirst].parent)
+    {
+        tourPull(tour, lastFirst);
+    }
+    for (; lastSecond != NO_TOKEN; lastSecond = tour->tokens[lastSecond].parent)
+    {
+        tourPull(tour, lastSecond);
+    }
+}
+
+/**
+ * Finds the root of the treap that holds the given token.
+ * @param tour the Euler tour forest
+ * @param t the token
+ * @return the root of its treap
+ */
+static int tourRoot(const EulerTour *tour, int t)
+{
+    while (tour->tokens[t].parent != NO_TOKEN)
+    {
+        t = tour->tokens[t].parent;
+    }
+    return t;
+}
+
+/**
+ * Finds the position of the given token in its tour.
+ * @param tour the Euler tour forest
+ * @param t the token
+ * @return the number of tokens before it
+ */
+static int tourPosition(const EulerTour *tour, int t)
+{
+    int position = tourSize(tour, tour->tokens[t].left);
+    for (int parent = tour->tokens[t].parent; parent != NO_TOKEN; t = parent, parent = tour->tokens[t].parent)
+    {
+        if (tour->tokens[parent].right == t)
+        {
+            position += tourSize(tour, tour->tokens[parent].left) + 1;
+        }
+    }
+    return position;
+}
+
+/**
+ * Returns the depth the given token stands for, including the additions its ancestors didn't pass down yet.
+ * @param tour the Euler tour forest
+ * @param t the token
+ * @return the depth
+ */
+static long long tourDepth(const EulerTour *tour, int t)
+{
+    long long depth = tour->tokens[t].depth;
+    for (int parent = tour->tokens[t].parent; parent != NO_TOKEN; parent = tour->tokens[parent].parent)
+    {
+        depth += tour->tokens[parent].lazy;
+    }
+    return depth;
+}
+
+/**
+ * Activates or deactivates the closing token of a node, when the node stops or starts being a root.
+ * @param tour the Euler tour forest
+ * @param t the closing token
+ * @param active 1 to activate it and 0 to deactivate it
+ */
+static void tourSetActive(EulerTour *tour, int t, int active)
+{
+    int root = tourRoot(tour, t);
+    int position = tourPosition(tour, t);
+    int first, middle, last;
+    tourSplit(tour, root, position, &first, &middle);
+    tourSplit(tour, middle, 1, &middle, &last);
+    tour->tokens[middle].active = active;
+    tourPull(tour, middle);
+    tourMerge(tour, tourMerge(tour, first, middle), last);
+}
+
+/**
+ * Carves the arrays of the Euler tour forest from an arena.
+ * @param tour the Euler tour forest
+ * @param numOfNodes the number of nodes of the forest
+ * @param arena the arena
+ * @return 1 if the arrays were carved and 0 if the arena is too small or only measures
+ */
+static int carveEulerTour(EulerTour *tour, int numOfNodes, Arena *arena)
+{
+    size_t n = (size_t)numOfNodes;
+    tour->tokens = (TourToken *)arenaAlloc(arena, 2 * sizeof(TourToken) * n);
+    tour->parents = (int *)arenaAlloc(arena, sizeof(int) * n);
+    tour->cartesian = (int *)arenaAlloc(arena, 2 * sizeof(int) * n);
+    return tour->tokens != NULL && tour->parents != NULL && tour->cartesian != NULL;
+}
+
+/**
+ * Allocates the arena of the Euler tour forest of the tree and carves its arrays from it.
+ * @param tree the tree
+ * @param tour the Euler tour forest
+ * @return VALID_INPUT enum if the forest was allocated and BAD_MEMORY_ALLOCATION enum otherwise
+ */
+static enum validityType newEulerTour(Tree *tree, EulerTour *tour)
+{
+    Arena counter = {NULL, 0, 0};
+    carveEulerTour(tour, tree->numOfNodes, &counter);
+    tour->arena.capacity = counter.used;
+    tour->arena.used = 0;
+    tour->arena.memory = (char *)malloc(counter.used);
+    if (tour->arena.memory == NULL)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    profileHeap(tree, counter.used);
+    carveEulerTour(tour, tree->numOfNodes, &tour->arena);
+    return VALID_INPUT;
+}
+
+/**
+ * Builds the Euler tour forest of the tree: node v has an opening token 2v with its depth and a closing token
+ * 2v + 1 with the depth of its parent, placed around the tokens of its subtree. The treap is built in linear
+ * time from the tour with the stack of a Cartesian tree.
+ * @param tree the tree, its traversal array is used as the DFS stack
+ * @param tour the Euler tour forest, with its arrays carved
+ */
+static void buildEulerTour(Tree *tree, EulerTour *tour)
+{
+    int n = tree->numOfNodes;
+    int *stack = tree->traversal;
+    int top = 0;
+    int *cartesian = tour->cartesian;
+    int cartesianTop = 0;
+    unsigned int seed = TOUR_SEED;
+    tour->numOfNodes = n;
+    for (int i = 0; i < n; ++i)
+    {
+        tree->nodes[i].distance = 0;
+        tour->parents[i] = tree->nodes[i].parentKey;
+    }
+    stack[top++] = tree->root;
+    int opening = 1;
+    int key = tree->root;
+    while (top > 0)
+    {
+        // the next token of the tour, the depth of a node is its place in the stack.
+        int t = opening ? 2 * key : 2 * key + 1;
+        TourToken *token = &tour->tokens[t];
+        token->left = NO_TOKEN;
+        token->right = NO_TOKEN;
+        token->parent = NO_TOKEN;
+        token->priority = nextPriority(&seed);
+        token->lazy = 0;
+        token->depth = opening ? top - 1 : top - 2;
+        token->active = opening || key != tree->root;
+        tourPull(tour, t);
+        int last = NO_TOKEN;
+        while (cartesianTop > 0 && tour->tokens[cartesian[cartesianTop - 1]].priority < token->priority)
+        {
+            last = cartesian[--cartesianTop];
+            tourPull(tour, last);
+        }
+        token->left = last;
+        if (last != NO_TOKEN)
+        {
+            tour->tokens[last].parent = t;
+        }
+        if (cartesianTop > 0)
+        {
+            tour->tokens[cartesian[cartesianTop - 1]].right = t;
+            token->parent = cartesian[cartesianTop - 1];
+        }
+        cartesian[cartesianTop++] = t;
+        if (!opening)
+        {
+            top--;
+        }
+        if (top == 0)
+        {
+            break;
+        }
+        Node *curNode = &tree->nodes[stack[top - 1]];
+        if (curNode->distance < curNode->numOfChildren)
+        {
+            key = curNode->children[curNode->distance++];
+            stack[top++] = key;
+            opening = 1;
+        }
+        else
+        {
+            key = curNode->key;
+            opening = 0;
+        }
+    }
+    while (cartesianTop > 0)
+    {
+        tourPull(tour, cartesian[--cartesianTop]);
+    }
+}
+
+/**
+ * Makes v, the root of one tree, a child of u in another tree: the tour of v is moved right after the
+ * opening token of u and its depths are moved by the depth of u plus one.
+ * @param tour the Euler tour forest
+ * @param u the new parent
+ * @param v the root to link
+ * @return VALID_INPUT enum if the nodes were linked and INVALID_INPUT enum otherwise
+ */
+static enum validityType tourLink(EulerTour *tour, int u, int v)
+{
+    if (tour->parents[v] != DEFAULT_PARENT || tourRoot(tour, 2 * u) == tourRoot(tour, 2 * v))
+    {
+        return INVALID_INPUT;
+    }
+    tourSetActive(tour, 2 * v + 1, 1);
+    int vTour = tourRoot(tour, 2 * v);
+    tourAdd(tour, vTour, tourDepth(tour, 2 * u) + 1);
+    int first, last;
+    tourSplit(tour, tourRoot(tour, 2 * u), tourPosition(tour, 2 * u) + 1, &first, &last);
+    tourMerge(tour, tourMerge(tour, first, vTour), last);
+    tour->parents[v] = u;
+    return VALID_INPUT;
+}
+
+/**
+ * Cuts the edge between u and its child v, the subtree of v becomes a tree with v as its root.
+ * @param tour the Euler tour forest
+ * @param u the parent
+ * @param v the child
+ * @return VALID_INPUT enum if the edge was cut and INVALID_INPUT enum if there is no such edge
+ */
+static enum validityType tourCut(EulerTour *tour, int u, int v)
+{
+    if (tour->parents[v] != u)
+    {
+        return INVALID_INPUT;
+    }
+    long long depth = tourDepth(tour, 2 * v);
+    int root = tourRoot(tour, 2 * v);
+    int opening = tourPosition(tour, 2 * v);
+    int closing = tourPosition(tour, 2 * v + 1);
+    int first, middle, last;
+    tourSplit(tour, root, opening, &first, &middle);
+    tourSplit(tour, middle, closing - opening + 1, &middle, &last);
+    tourMerge(tour, first, last);
+    tourAdd(tour, middle, -depth);
+    tour->parents[v] = DEFAULT_PARENT;
+    tourSetActive(tour, 2 * v + 1, 0);
+    return VALID_INPUT;
+}
+
+/**
+ * Calculates the distance between u and v: the sum of their depths minus twice the smallest depth on the
+ * tour between them, which is the depth of their lowest common ancestor.
+ * @param tour the Euler tour forest
+ * @param u the first vertex
+ * @param v the second vertex
+ * @return the distance, or -1 if u and v are in different trees
+ */
+static long long tourDistance(EulerTour *tour, int u, int v)
+{
+    int root = tourRoot(tour, 2 * u);
+    if (root != tourRoot(tour, 2 * v))
+    {
+        return -1;
+    }
+    int uPosition = tourPosition(tour, 2 * u);
+    int vPosition = tourPosition(tour, 2 * v);
+    int low = (uPosition < vPosition) ? uPosition : vPosition;
+    int high = (uPosition < vPosition) ? vPosition : uPosition;
+    long long distance = tourDepth(tour, 2 * u) + tourDepth(tour, 2 * v);
+    int first, middle, last;
+    tourSplit(tour, root, low, &first, &middle);
+    tourSplit(tour, middle, high - low + 1, &middle, &last);
+    distance -= 2 * tour->tokens[middle].minDepth;
+    tourMerge(tour, tourMerge(tour, first, middle), last);
+    return distance;
+}
+
+/**
+ * Returns the diameter of the tree of u, kept in the root of its treap.
+ * @param tour the Euler tour forest
+ * @param u a vertex of the tree
+ * @return the diameter
+ */
+static long long tourDiameter(const EulerTour *tour, int u)
+{
+    return tour->tokens[tourRoot(tour, 2 * u)].best;
+}
+
+/**
+ * Runs the commands of a dynamic tree script on the tree: "link u v" makes the root v a child of u,
+ * "cut u v" cuts the edge between u and its child v, "query u v" prints the distance between u and v
+ * (-1 if they are not connected) and "diameter u" prints the diameter of the tree of u.
+ * Every command takes O(log n) expected time. A command that can't be done is reported and skipped.
+ * @param tree the analyzed tree
+ * @param scriptPath the path of the script, "-" for the standard input
+ * @return VALID_INPUT enum if the script was run, INVALID_INPUT enum if it couldn't be opened and
+ * BAD_MEMORY_ALLOCATION enum if there was no memory for the Euler tour
+ */
+enum validityType runDynamicScript(Tree *tree, const char *scriptPath)
+{
+    EulerTour tour;
+    char line[COMMAND_LEN];
+    char command[COMMAND_LEN];
+    FILE *script = (strcmp(scriptPath, STDIN_PATH) == 0) ? stdin : fopen(scriptPath, "r");
+    if (script == NULL)
+    {
+        return INVALID_INPUT;
+    }
+    if (newEulerTour(tree, &tour) != VALID_INPUT)
+    {
+        if (script != stdin)
+        {
+            fclose(script);
+        }
+        return BAD_MEMORY_ALLOCATION;
+    }
+    buildEulerTour(tree, &tour);
+    while (fgets(line, COMMAND_LEN, script) != NULL)
+    {
+        int u = 0;
+        int v = 0;
+        int numOfFields = sscanf(line, COMMAND_FORMAT, command, &u, &v);
+        if (numOfFields <= 0)
+        {
+            continue;
+        }
+        enum validityType result = INVALID_INPUT;
+        int inRange = u >= 0 && u < tree->numOfNodes && v >= 0 && v < tree->numOfNodes;
+        if (numOfFields == 3 && inRange && strcmp(command, LINK_COMMAND) == 0)
+        {
+            result = tourLink(&tour, u, v);
+        }
+        else if (numOfFields == 3 && inRange && strcmp(command, CUT_COMMAND) == 0)
+        {
+            result = tourCut(&tour, u, v);
+        }
+        else if (numOfFields == 3 && inRange && strcmp(command, QUERY_COMMAND) == 0)
+        {
+            printf("Distance Between %d and %d: %lld\n", u, v, tourDistance(&tour, u, v));
+            result = VALID_INPUT;
+        }
+        else if (numOfFields == 2 && inRange && strcmp(command, DIAMETER_COMMAND) == 0)
+        {
+            printf("Diameter Length: %lld\n", tourDiameter(&tour, u));
+            result = VALID_INPUT;
+        }
+        if (result != VALID_INPUT)
+        {
+            fprintf(stderr, INVALID_COMMAND_MSG, line);
+        }
+    }
+    if (script != stdin)
+    {
+        fclose(script);
+    }
+    free(tour.arena.memory);
+    return VALID_INPUT;
+}
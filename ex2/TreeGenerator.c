@@ -0,0 +1,357 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GENERATOR_USAGE_MSG "Usage: TreeGenerator <path|star|kary|caterpillar|prufer> <Number Of Vertices> " \
+                            "[Seed] [Arity]\n"
+#define GENERATOR_INVALID_MSG "Invalid generator arguments\n"
+#define GENERATOR_MEMORY_MSG "Memory allocation failed\n"
+#define GENERATOR_MIN_ARGS 3
+#define GENERATOR_MAX_ARGS 5
+#define GENERATOR_BASE 10
+#define GENERATOR_DEFAULT_SEED 1
+#define GENERATOR_DEFAULT_ARITY 2
+#define GENERATOR_BUFFER_LEN 65536
+#define GENERATOR_NUMBER_LEN 12
+#define GENERATOR_LEAF "-"
+
+/**
+ * The shapes of trees the generator makes.
+ */
+enum treeShape
+        {
+    PATH_SHAPE,
+    STAR_SHAPE,
+    KARY_SHAPE,
+    CATERPILLAR_SHAPE,
+    PRUFER_SHAPE,
+    UNKNOWN_SHAPE
+        };
+
+/**
+ * structure that buffers the output of the generator, the trees are written a number at a time.
+ */
+typedef struct TreeWriter
+{
+    FILE *out;
+    size_t used;
+    int failed;
+    char buffer[GENERATOR_BUFFER_LEN];
+} TreeWriter;
+
+/**
+ * Writes the buffered output of the writer.
+ * @param writer the writer
+ */
+static void flushWriter(TreeWriter *writer)
+{
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->out) != writer->used)
+    {
+        writer->failed = 1;
+    }
+    writer->used = 0;
+}
+
+/**
+ * Writes a number, preceded by a space unless it is the first on its line.
+ * @param writer the writer
+ * @param value the number
+ * @param first 1 if the number starts its line and 0 otherwise
+ */
+static void writeNumber(TreeWriter *writer, int value, int first)
+{
+    char digits[GENERATOR_NUMBER_LEN];
+    int len = 0;
+    if (writer->used + GENERATOR_NUMBER_LEN + 1 > GENERATOR_BUFFER_LEN)
+    {
+        flushWriter(writer);
+    }
+    if (!first)
+    {
+        writer->buffer[writer->used++] = ' ';
+    }
+    do
+    {
+        digits[len++] = (char)('0' + value % GENERATOR_BASE);
+        value /= GENERATOR_BASE;
+    } while (value > 0);
+    while (len > 0)
+    {
+        writer->buffer[writer->used++] = digits[--len];
+    }
+}
+
+/**
+ * Ends the current line, a line without numbers is written as a leaf.
+ * @param writer the writer
+ * @param empty 1 if no number was written on the line and 0 otherwise
+ */
+static void endLine(TreeWriter *writer, int empty)
+{
+    if (writer->used + 2 > GENERATOR_BUFFER_LEN)
+    {
+        flushWriter(writer);
+    }
+    if (empty)
+    {
+        writer->buffer[writer->used++] = GENERATOR_LEAF[0];
+    }
+    writer->buffer[writer->used++] = '\n';
+}
+
+/**
+ * Returns the next number of a xorshift generator.
+ * @param state the state of the generator, not 0
+ * @return the number
+ */
+static unsigned long long nextRandom(unsigned long long *state)
+{
+    *state ^= *state << 13u;
+    *state ^= *state >> 7u;
+    *state ^= *state << 17u;
+    return *state;
+}
+
+/**
+ * Writes the children of a vertex of a path, star, complete k-ary tree or caterpillar, all their children
+ * follow from the key of the vertex.
+ * The caterpillar has a spine of n / 2 vertices, leg j hangs from spine vertex (j - spine) % spine.
+ * @param writer the writer
+ * @param shape the shape of the tree
+ * @param n the number of vertices
+ * @param arity the arity of a k-ary tree
+ * @param key the vertex
+ */
+static void writeShapeChildren(TreeWriter *writer, enum treeShape shape, int n, int arity, int key)
+{
+    int empty = 1;
+    if (shape == PATH_SHAPE && key + 1 < n)
+    {
+        writeNumber(writer, key + 1, 1);
+        empty = 0;
+    }
+    else if (shape == STAR_SHAPE && key == 0)
+    {
+        for (int child = 1; child < n; ++child)
+        {
+            writeNumber(writer, child, empty);
+            empty = 0;
+        }
+    }
+    else if (shape == KARY_SHAPE)
+    {
+        for (long long child = (long long)key * arity + 1; child <= (long long)key * arity + arity && child < n;
+             ++child)
+        {
+            writeNumber(writer, (int)child, empty);
+            empty = 0;
+        }
+    }
+    else if (shape == CATERPILLAR_SHAPE)
+    {
+        int spine = (n / 2 > 0) ? n / 2 : 1;
+        if (key < spine)
+        {
+            if (key + 1 < spine)
+            {
+                writeNumber(writer, key + 1, empty);
+                empty = 0;
+            }
+            for (long long leg = (long long)spine + key; leg < n; leg += spine)
+            {
+                writeNumber(writer, (int)leg, empty);
+                empty = 0;
+            }
+        }
+    }
+    endLine(writer, empty);
+}
+
+/**
+ * Writes a uniform random tree, decoded in linear time from a random Prüfer sequence.
+ * The tree is rooted at vertex n - 1.
+ * @param writer the writer
+ * @param n the number of vertices
+ * @param seed the seed of the sequence
+ * @return 0 on success and 1 if the memory couldn't be allocated
+ */
+static int writePruferTree(TreeWriter *writer, int n, unsigned long long seed)
+{
+    int *parents = (int *)malloc(sizeof(int) * (size_t)n);
+    int *degrees = (int *)calloc((size_t)n + 1, sizeof(int));
+    int *children = (int *)malloc(sizeof(int) * (size_t)n);
+    if (parents == NULL || degrees == NULL || children == NULL)
+    {
+        free(parents);
+        free(degrees);
+        free(children);
+        return 1;
+    }
+    // the sequence is kept in children until it is decoded.
+    for (int i = 0; i < n; ++i)
+    {
+        degrees[i] = 1;
+    }
+    for (int i = 0; i + 2 < n; ++i)
+    {
+        children[i] = (int)(nextRandom(&seed) % (unsigned long long)n);
+        degrees[children[i]]++;
+    }
+    parents[n - 1] = -1;
+    if (n > 1)
+    {
+        int pointer = 0;
+        while (degrees[pointer] != 1)
+        {
+            pointer++;
+        }
+        int leaf = pointer;
+        for (int i = 0; i + 2 < n; ++i)
+        {
+            int next = children[i];
+            parents[leaf] = next;
+            if (--degrees[next] == 1 && next < pointer)
+            {
+                leaf = next;
+            }
+            else
+            {
+                do
+                {
+                    pointer++;
+                } while (degrees[pointer] != 1);
+                leaf = pointer;
+            }
+        }
+        parents[leaf] = n - 1;
+    }
+    // the children of every vertex are placed by a counting sort of the parents, degrees holds the offsets.
+    memset(degrees, 0, sizeof(int) * ((size_t)n + 1));
+    for (int i = 0; i < n; ++i)
+    {
+        if (parents[i] >= 0)
+        {
+            degrees[parents[i] + 1]++;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        degrees[i + 1] += degrees[i];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        if (parents[i] >= 0)
+        {
+            children[degrees[parents[i]]++] = i;
+        }
+    }
+    // after the placement degrees[i] is where the children of i + 1 start.
+    for (int i = 0; i < n; ++i)
+    {
+        int start = (i == 0) ? 0 : degrees[i - 1];
+        for (int j = start; j < degrees[i]; ++j)
+        {
+            writeNumber(writer, children[j], j == start);
+        }
+        endLine(writer, start == degrees[i]);
+    }
+    free(parents);
+    free(degrees);
+    free(children);
+    return 0;
+}
+
+/**
+ * Finds the shape of the given name.
+ * @param name the name of the shape
+ * @return the shape, UNKNOWN_SHAPE if there is no such shape
+ */
+enum treeShape shapeFromName(const char *name)
+{
+    const char *names[] = {"path", "star", "kary", "caterpillar", "prufer"};
+    for (int shape = PATH_SHAPE; shape < UNKNOWN_SHAPE; ++shape)
+    {
+        if (strcmp(name, names[shape]) == 0)
+        {
+            return (enum treeShape)shape;
+        }
+    }
+    return UNKNOWN_SHAPE;
+}
+
+/**
+ * Writes a tree in the format of TreeAnalyzer: the number of vertices, then a line for every vertex with its
+ * children or "-" for a leaf.
+ * @param out the stream to write to
+ * @param shape the shape of the tree
+ * @param n the number of vertices
+ * @param arity the arity of a k-ary tree
+ * @param seed the seed of a random tree
+ * @return 0 on success and 1 on a failure
+ */
+int generateTree(FILE *out, enum treeShape shape, int n, int arity, unsigned long long seed)
+{
+    static TreeWriter writer;
+    writer.out = out;
+    writer.used = 0;
+    writer.failed = 0;
+    writeNumber(&writer, n, 1);
+    endLine(&writer, 0);
+    if (shape == PRUFER_SHAPE)
+    {
+        if (writePruferTree(&writer, n, (seed == 0) ? GENERATOR_DEFAULT_SEED : seed) != 0)
+        {
+            fprintf(stderr, GENERATOR_MEMORY_MSG);
+            return 1;
+        }
+    }
+    else
+    {
+        for (int key = 0; key < n; ++key)
+        {
+            writeShapeChildren(&writer, shape, n, arity, key);
+        }
+    }
+    flushWriter(&writer);
+    return writer.failed;
+}
+
+#ifndef TREE_GENERATOR_NO_MAIN
+/**
+ * Generates a tree of the given shape and size to the standard output.
+ * @param argc number of given arguments
+ * @param argv the shape, the number of vertices, and optionally the seed and the arity of a k-ary tree
+ * @return 1 if the program failed and 0 otherwise
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < GENERATOR_MIN_ARGS || argc > GENERATOR_MAX_ARGS)
+    {
+        fprintf(stderr, GENERATOR_USAGE_MSG);
+        return EXIT_FAILURE;
+    }
+    char *end;
+    enum treeShape shape = shapeFromName(argv[1]);
+    long n = strtol(argv[2], &end, GENERATOR_BASE);
+    int valid = shape != UNKNOWN_SHAPE && *end == '\0' && n >= 1 && n < (1L << 30);
+    unsigned long long seed = GENERATOR_DEFAULT_SEED;
+    long arity = GENERATOR_DEFAULT_ARITY;
+    if (valid && argc > GENERATOR_MIN_ARGS)
+    {
+        seed = strtoull(argv[3], &end, GENERATOR_BASE);
+        valid = *end == '\0';
+    }
+    if (valid && argc > GENERATOR_MIN_ARGS + 1)
+    {
+        arity = strtol(argv[4], &end, GENERATOR_BASE);
+        valid = *end == '\0' && arity >= 1 && arity < (1L << 30);
+    }
+    if (!valid)
+    {
+        fprintf(stderr, GENERATOR_INVALID_MSG);
+        return EXIT_FAILURE;
+    }
+    return (generateTree(stdout, shape, (int)n, (int)arity, seed) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
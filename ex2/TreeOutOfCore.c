@@ -0,0 +1,1033 @@
+/**
+ * The out of core mode of TreeAnalyzer: a tree that may be larger than the memory is analyzed with all its
+ * arrays kept in files. The analysis is made of passes that read and write those files in order, level by level,
+ * so only a memory budget of buffers is held at once.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "TreeAnalyzer.h"
+
+#define OUT_OF_CORE_FILE_TEMPLATE "TreeAnalyzerXXXXXX"
+#define BYTES_IN_MB (1LL << 20)
+#define STREAM_BLOCK_BYTES (1LL << 15)
+#define SPARSE_BLOCK_BYTES (1LL << 12)
+#define MIN_LEVEL_CAPACITY 4096
+#define NO_PARENT_POSITION -1
+
+/**
+ * the files of an out of core tree.
+ * OFFSETS_FILE and CHILDREN_FILE hold the children of node i at children[offsets[i]] to children[offsets[i + 1] - 1].
+ * ORDER_FILE holds the levels of the tree one after the other, each level sorted by key, as pairs of a key and the
+ * position of its parent in the level above. LEVELS_FILE holds the size of every level.
+ * SPILL_FILE, RUNS_FILE and SORTED_FILE are scratch files for levels that don't fit in memory, the spill and the
+ * sorted files hold the two sides of the path at the end.
+ */
+enum scratchFile
+{
+    OFFSETS_FILE,
+    CHILDREN_FILE,
+    ORDER_FILE,
+    LEVELS_FILE,
+    SPILL_FILE,
+    RUNS_FILE,
+    SORTED_FILE,
+    NUM_OF_SCRATCH_FILES
+};
+
+/**
+ * structure that represents a pair of ints, which are sorted by the first int and then by the second.
+ */
+typedef struct Pair
+{
+    int first;
+    int second;
+} Pair;
+
+/**
+ * structure that represents a buffered writer that appends to a file from a given offset.
+ */
+typedef struct FileWriter
+{
+    int fd;
+    int failed;
+    char *buffer;
+    long long used;
+    long long offset;
+} FileWriter;
+
+/**
+ * structure that represents a buffered reader of a file, that reads the aligned block that holds the requested
+ * bytes. Reading in order, forward or backward, reads every block once.
+ */
+typedef struct FileCursor
+{
+    int fd;
+    int failed;
+    char *block;
+    long long blockBytes;
+    long long blockFirst;
+    long long blockLen;
+} FileCursor;
+
+/**
+ * structure that represents a level of pairs that is built and then read in order. The level is held in memory
+ * while it fits in the level capacity, and is sorted through the scratch files otherwise.
+ */
+typedef struct PairLevel
+{
+    Pair *pairs;
+    long long count;
+    int inMemory;
+    int fd;
+    long long first;
+} PairLevel;
+
+/**
+ * structure that represents a tree that is analyzed out of core. Every file has a writer and a cursor, the path
+ * cursor is a second cursor on the order file.
+ */
+typedef struct OutOfCoreTree
+{
+    int numOfNodes;
+    int root;
+    int numOfLevels;
+    long long capacity;
+    int files[NUM_OF_SCRATCH_FILES];
+    FileWriter writers[NUM_OF_SCRATCH_FILES];
+    FileCursor cursors[NUM_OF_SCRATCH_FILES];
+    FileCursor pathCursor;
+    PairLevel levels[2];
+} OutOfCoreTree;
+
+/**
+ * structure that represents where a vertex is in the order file and the nodes that were written on its side of
+ * the path.
+ */
+typedef struct LevelPosition
+{
+    int level;
+    int position;
+    long long levelFirst;
+    long long sideLen;
+} LevelPosition;
+
+/**
+ * Reads size bytes from the given offset of a file.
+ * @param fd the file
+ * @param data the memory that gets the bytes
+ * @param size the number of bytes
+ * @param offset the offset in the file
+ * @return 1 if all the bytes were read and 0 otherwise
+ */
+static int readFully(int fd, void *data, long long size, long long offset)
+{
+    char *bytes = (char *)data;
+    while (size > 0)
+    {
+        ssize_t numOfBytes = pread(fd, bytes, (size_t)size, (off_t)offset);
+        if (numOfBytes <= 0)
+        {
+            return 0;
+        }
+        bytes += numOfBytes;
+        size -= numOfBytes;
+        offset += numOfBytes;
+    }
+    return 1;
+}
+
+/**
+ * Writes size bytes at the given offset of a file.
+ * @param fd the file
+ * @param data the bytes
+ * @param size the number of bytes
+ * @param offset the offset in the file
+ * @return 1 if all the bytes were written and 0 otherwise
+ */
+static int writeFully(int fd, const void *data, long long size, long long offset)
+{
+    const char *bytes = (const char *)data;
+    while (size > 0)
+    {
+        ssize_t numOfBytes = pwrite(fd, bytes, (size_t)size, (off_t)offset);
+        if (numOfBytes <= 0)
+        {
+            return 0;
+        }
+        bytes += numOfBytes;
+        size -= numOfBytes;
+        offset += numOfBytes;
+    }
+    return 1;
+}
+
+/**
+ * Writes the buffered bytes of a writer to its file.
+ * @param writer the writer
+ */
+static void flushWriter(FileWriter *writer)
+{
+    if (writer->used > 0 && !writeFully(writer->fd, writer->buffer, writer->used, writer->offset))
+    {
+        writer->failed = 1;
+    }
+    writer->offset += writer->used;
+    writer->used = 0;
+}
+
+/**
+ * Flushes a writer and moves it to the given offset of its file.
+ * @param writer the writer
+ * @param offset the offset of the next byte that is written
+ */
+static void seekWriter(FileWriter *writer, long long offset)
+{
+    flushWriter(writer);
+    writer->offset = offset;
+}
+
+/**
+ * Appends bytes to a writer.
+ * @param writer the writer
+ * @param data the bytes
+ * @param size the number of bytes
+ */
+static void writeBytes(FileWriter *writer, const void *data, long long size)
+{
+    if (writer->used + size > STREAM_BLOCK_BYTES)
+    {
+        flushWriter(writer);
+    }
+    if (size > STREAM_BLOCK_BYTES)
+    {
+        if (!writeFully(writer->fd, data, size, writer->offset))
+        {
+            writer->failed = 1;
+        }
+        writer->offset += size;
+        return;
+    }
+    memcpy(writer->buffer + writer->used, data, (size_t)size);
+    writer->used += size;
+}
+
+/**
+ * Appends an int to a writer.
+ * @param writer the writer
+ * @param value the int
+ */
+static void writeInt(FileWriter *writer, int value)
+{
+    writeBytes(writer, &value, sizeof(int));
+}
+
+/**
+ * Points a cursor at a file, dropping the block it holds. Has to be called after the bytes of the block were
+ * written.
+ * @param cursor the cursor
+ * @param fd the file
+ */
+static void resetCursor(FileCursor *cursor, int fd)
+{
+    cursor->fd = fd;
+    cursor->blockFirst = 0;
+    cursor->blockLen = 0;
+}
+
+/**
+ * Returns the bytes at the given offset of the file of a cursor, reading the block that holds them if needed.
+ * If they can't be read the cursor is marked as failed and zeros are returned.
+ * @param cursor the cursor
+ * @param offset the offset of the bytes, size has to divide the block size and the offset
+ * @param size the number of bytes
+ * @return a pointer to the bytes
+ */
+static const char *cursorAt(FileCursor *cursor, long long offset, long long size)
+{
+    if (offset < cursor->blockFirst || offset + size > cursor->blockFirst + cursor->blockLen)
+    {
+        cursor->blockFirst = offset - offset % cursor->blockBytes;
+        cursor->blockLen = pread(cursor->fd, cursor->block, (size_t)cursor->blockBytes, (off_t)cursor->blockFirst);
+        if (cursor->blockLen < offset + size - cursor->blockFirst)
+        {
+            cursor->failed = 1;
+            cursor->blockLen = 0;
+            memset(cursor->block, 0, (size_t)size);
+            return cursor->block;
+        }
+    }
+    return cursor->block + (offset - cursor->blockFirst);
+}
+
+/**
+ * Returns the int at the given index of the file of a cursor.
+ * @param cursor the cursor
+ * @param index the index of the int
+ * @return the int
+ */
+static int intAt(FileCursor *cursor, long long index)
+{
+    int value;
+    memcpy(&value, cursorAt(cursor, index * (long long)sizeof(int), sizeof(int)), sizeof(int));
+    return value;
+}
+
+/**
+ * Returns the pair at the given index of the file of a cursor.
+ * @param cursor the cursor
+ * @param index the index of the pair
+ * @return the pair
+ */
+static Pair pairAt(FileCursor *cursor, long long index)
+{
+    Pair pair;
+    memcpy(&pair, cursorAt(cursor, index * (long long)sizeof(Pair), sizeof(Pair)), sizeof(Pair));
+    return pair;
+}
+
+/**
+ * Compares two pairs by their first ints and then by their second ints, for qsort.
+ * @param first the first pair
+ * @param second the second pair
+ * @return a negative number, zero or a positive number if the first pair is smaller, equal or bigger
+ */
+static int comparePairs(const void *first, const void *second)
+{
+    const Pair *a = (const Pair *)first;
+    const Pair *b = (const Pair *)second;
+    if (a->first != b->first)
+    {
+        return (a->first < b->first) ? -1 : 1;
+    }
+    return (a->second < b->second) ? -1 : (a->second > b->second);
+}
+
+/**
+ * structure that represents a sorted run of the runs file while it is merged.
+ */
+typedef struct SortedRun
+{
+    Pair *pairs;
+    long long next;
+    long long end;
+    long long head;
+    long long len;
+} SortedRun;
+
+/**
+ * Moves the run at the given place of a heap of runs down until the heap is ordered by the heads of the runs.
+ * @param runs the runs
+ * @param heap the indices of the runs, the run with the smallest head is first
+ * @param heapLen the number of runs in the heap
+ * @param place the place of the run to move down
+ */
+static void siftRunDown(const SortedRun *runs, long long *heap, long long heapLen, long long place)
+{
+    while (2 * place + 1 < heapLen)
+    {
+        long long child = 2 * place + 1;
+        if (child + 1 < heapLen && comparePairs(&runs[heap[child + 1]].pairs[runs[heap[child + 1]].head],
+                                                &runs[heap[child]].pairs[runs[heap[child]].head]) < 0)
+        {
+            child++;
+        }
+        if (comparePairs(&runs[heap[child]].pairs[runs[heap[child]].head],
+                         &runs[heap[place]].pairs[runs[heap[place]].head]) >= 0)
+        {
+            return;
+        }
+        long long temp = heap[place];
+        heap[place] = heap[child];
+        heap[child] = temp;
+        place = child;
+    }
+}
+
+/**
+ * Sorts the first count pairs of a file into a writer. If they don't fit in the buffer, sorted runs of the
+ * buffer size are written to the runs file and merged, each run reading through its own part of the buffer.
+ * @param tree the out of core tree
+ * @param buffer a buffer of tree->capacity pairs
+ * @param fd the file of the pairs
+ * @param count the number of pairs
+ * @param dest the writer that gets the sorted pairs
+ * @return VALID_INPUT enum if the pairs were sorted, FILE_WRITE_FAILED enum if a file couldn't be read or written
+ * and BAD_MEMORY_ALLOCATION enum if there was no memory or the budget is too small for the number of runs
+ */
+static enum validityType sortPairs(OutOfCoreTree *tree, Pair *buffer, int fd, long long count, FileWriter *dest)
+{
+    long long capacity = tree->capacity;
+    if (count <= capacity)
+    {
+        if (!readFully(fd, buffer, count * (long long)sizeof(Pair), 0))
+        {
+            return FILE_WRITE_FAILED;
+        }
+        qsort(buffer, (size_t)count, sizeof(Pair), comparePairs);
+        writeBytes(dest, buffer, count * (long long)sizeof(Pair));
+        return VALID_INPUT;
+    }
+    long long numOfRuns = (count + capacity - 1) / capacity;
+    if (numOfRuns > capacity)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    for (long long first = 0; first < count; first += capacity)
+    {
+        long long len = (count - first < capacity) ? count - first : capacity;
+        if (!readFully(fd, buffer, len * (long long)sizeof(Pair), first * (long long)sizeof(Pair)))
+        {
+            return FILE_WRITE_FAILED;
+        }
+        qsort(buffer, (size_t)len, sizeof(Pair), comparePairs);
+        if (!writeFully(tree->files[RUNS_FILE], buffer, len * (long long)sizeof(Pair),
+                        first * (long long)sizeof(Pair)))
+        {
+            return FILE_WRITE_FAILED;
+        }
+    }
+    SortedRun *runs = (SortedRun *)malloc(sizeof(SortedRun) * (size_t)numOfRuns);
+    long long *heap = (long long *)malloc(sizeof(long long) * (size_t)numOfRuns);
+    if (runs == NULL || heap == NULL)
+    {
+        free(runs);
+        free(heap);
+        return BAD_MEMORY_ALLOCATION;
+    }
+    long long sliceLen = capacity / numOfRuns;
+    enum validityType result = VALID_INPUT;
+    for (long long i = 0; i < numOfRuns; ++i)
+    {
+        runs[i].pairs = buffer + i * sliceLen;
+        runs[i].next = i * capacity;
+        runs[i].end = (runs[i].next + capacity < count) ? runs[i].next + capacity : count;
+        runs[i].head = 0;
+        runs[i].len = 0;
+        heap[i] = i;
+    }
+    long long heapLen = numOfRuns;
+    for (long long i = 0; i < numOfRuns && result == VALID_INPUT; ++i)
+    {
+        SortedRun *run = &runs[i];
+        run->len = (run->end - run->next < sliceLen) ? run->end - run->next : sliceLen;
+        result = readFully(tree->files[RUNS_FILE], run->pairs, run->len * (long long)sizeof(Pair),
+                           run->next * (long long)sizeof(Pair)) ? VALID_INPUT : FILE_WRITE_FAILED;
+        run->next += run->len;
+    }
+    for (long long place = heapLen / 2 - 1; place >= 0 && result == VALID_INPUT; --place)
+    {
+        siftRunDown(runs, heap, heapLen, place);
+    }
+    while (heapLen > 0 && result == VALID_INPUT)
+    {
+        SortedRun *run = &runs[heap[0]];
+        writeBytes(dest, &run->pairs[run->head++], sizeof(Pair));
+        if (run->head == run->len)
+        {
+            if (run->next == run->end)
+            {
+                heap[0] = heap[--heapLen];
+            }
+            else
+            {
+                run->len = (run->end - run->next < sliceLen) ? run->end - run->next : sliceLen;
+                run->head = 0;
+                result = readFully(tree->files[RUNS_FILE], run->pairs, run->len * (long long)sizeof(Pair),
+                                   run->next * (long long)sizeof(Pair)) ? VALID_INPUT : FILE_WRITE_FAILED;
+                run->next += run->len;
+            }
+        }
+        siftRunDown(runs, heap, heapLen, 0);
+    }
+    free(runs);
+    free(heap);
+    return result;
+}
+
+/**
+ * Empties a level of pairs, the level is held in memory until it outgrows the level capacity.
+ * @param level the level
+ */
+static void clearLevel(PairLevel *level)
+{
+    level->count = 0;
+    level->inMemory = 1;
+}
+
+/**
+ * Adds a pair to a level. When the level outgrows the level capacity its pairs go on in the spill file.
+ * @param tree the out of core tree
+ * @param level the level
+ * @param pair the pair
+ */
+static void addToLevel(OutOfCoreTree *tree, PairLevel *level, Pair pair)
+{
+    FileWriter *spill = &tree->writers[SPILL_FILE];
+    if (level->inMemory && level->count == tree->capacity)
+    {
+        seekWriter(spill, 0);
+        writeBytes(spill, level->pairs, level->count * (long long)sizeof(Pair));
+        level->inMemory = 0;
+    }
+    if (level->inMemory)
+    {
+        level->pairs[level->count] = pair;
+    }
+    else
+    {
+        writeBytes(spill, &pair, sizeof(Pair));
+    }
+    level->count++;
+}
+
+/**
+ * Sorts a level of pairs. A level in memory is sorted in place, and is written to the destination too if keep
+ * is set. A level in the spill file is sorted into the destination and read from there.
+ * @param tree the out of core tree
+ * @param level the level
+ * @param destIndex the scratch file that gets the sorted level, from the current offset of its writer
+ * @param keep 1 if a level in memory is written to the destination too
+ * @return VALID_INPUT enum if the level was sorted, and the problem of sortPairs otherwise
+ */
+static enum validityType sortLevel(OutOfCoreTree *tree, PairLevel *level, int destIndex, int keep)
+{
+    FileWriter *dest = &tree->writers[destIndex];
+    if (level->inMemory)
+    {
+        qsort(level->pairs, (size_t)level->count, sizeof(Pair), comparePairs);
+        if (keep)
+        {
+            writeBytes(dest, level->pairs, level->count * (long long)sizeof(Pair));
+        }
+        return VALID_INPUT;
+    }
+    flushWriter(&tree->writers[SPILL_FILE]);
+    level->fd = tree->files[destIndex];
+    level->first = (dest->offset + dest->used) / (long long)sizeof(Pair);
+    enum validityType result = sortPairs(tree, level->pairs, tree->files[SPILL_FILE], level->count, dest);
+    flushWriter(dest);
+    return result;
+}
+
+/**
+ * Returns the pair at the given index of a sorted level.
+ * @param level the level
+ * @param cursor a cursor on the file of the level, used if the level isn't in memory
+ * @param index the index of the pair
+ * @return the pair
+ */
+static Pair levelPair(const PairLevel *level, FileCursor *cursor, long long index)
+{
+    return level->inMemory ? level->pairs[index] : pairAt(cursor, level->first + index);
+}
+
+/**
+ * Returns the problem of the first writer or cursor that failed.
+ * @param tree the out of core tree
+ * @return FILE_WRITE_FAILED enum if a file couldn't be read or written and VALID_INPUT enum otherwise
+ */
+static enum validityType streamsResult(const OutOfCoreTree *tree)
+{
+    int failed = tree->pathCursor.failed;
+    for (int i = 0; i < NUM_OF_SCRATCH_FILES; ++i)
+    {
+        failed |= tree->writers[i].failed | tree->cursors[i].failed;
+    }
+    return failed ? FILE_WRITE_FAILED : VALID_INPUT;
+}
+
+/**
+ * Opens the scratch files of the tree as unlinked files in the given directory, and allocates their buffers and
+ * the two level buffers. The level capacity is what is left of the memory budget after the stream buffers.
+ * @param tree the out of core tree
+ * @param options the options of the program
+ * @return VALID_INPUT enum if the files were opened, FILE_WRITE_FAILED enum if a file couldn't be created
+ * and BAD_MEMORY_ALLOCATION enum if there was no memory
+ */
+static enum validityType openOutOfCoreTree(OutOfCoreTree *tree, const Options *options)
+{
+    char path[PATH_MAX];
+    long long streamBytes = (2 * NUM_OF_SCRATCH_FILES + 1) * STREAM_BLOCK_BYTES;
+    long long capacity = (options->memoryBudget * BYTES_IN_MB - streamBytes) / (2 * (long long)sizeof(Pair));
+    capacity = (capacity < MIN_LEVEL_CAPACITY) ? MIN_LEVEL_CAPACITY : capacity;
+    tree->capacity = (capacity > tree->numOfNodes) ? tree->numOfNodes : capacity;
+    for (int i = 0; i < NUM_OF_SCRATCH_FILES; ++i)
+    {
+        if (snprintf(path, sizeof(path), "%s/%s", options->outOfCoreDirectory, OUT_OF_CORE_FILE_TEMPLATE) >=
+            (int)sizeof(path))
+        {
+            return FILE_WRITE_FAILED;
+        }
+        tree->files[i] = mkstemp(path);
+        if (tree->files[i] < 0)
+        {
+            return FILE_WRITE_FAILED;
+        }
+        // the file is removed when it is closed.
+        unlink(path);
+        tree->writers[i].fd = tree->files[i];
+        tree->writers[i].buffer = (char *)malloc((size_t)STREAM_BLOCK_BYTES);
+        tree->cursors[i].fd = tree->files[i];
+        tree->cursors[i].blockBytes = (i == OFFSETS_FILE || i == CHILDREN_FILE) ? SPARSE_BLOCK_BYTES
+                                                                                : STREAM_BLOCK_BYTES;
+        tree->cursors[i].block = (char *)malloc((size_t)tree->cursors[i].blockBytes);
+        if (tree->writers[i].buffer == NULL || tree->cursors[i].block == NULL)
+        {
+            return BAD_MEMORY_ALLOCATION;
+        }
+    }
+    tree->pathCursor.fd = tree->files[ORDER_FILE];
+    tree->pathCursor.blockBytes = STREAM_BLOCK_BYTES;
+    tree->pathCursor.block = (char *)malloc((size_t)STREAM_BLOCK_BYTES);
+    for (int i = 0; i < 2; ++i)
+    {
+        tree->levels[i].pairs = (Pair *)malloc(sizeof(Pair) * (size_t)tree->capacity);
+        if (tree->levels[i].pairs == NULL)
+        {
+            return BAD_MEMORY_ALLOCATION;
+        }
+    }
+    return (tree->pathCursor.block == NULL) ? BAD_MEMORY_ALLOCATION : VALID_INPUT;
+}
+
+/**
+ * Closes the scratch files of the tree and frees its buffers.
+ * @param tree the out of core tree
+ */
+static void closeOutOfCoreTree(OutOfCoreTree *tree)
+{
+    for (int i = 0; i < NUM_OF_SCRATCH_FILES; ++i)
+    {
+        if (tree->files[i] >= 0)
+        {
+            close(tree->files[i]);
+        }
+        free(tree->writers[i].buffer);
+        free(tree->cursors[i].block);
+    }
+    free(tree->pathCursor.block);
+    free(tree->levels[0].pairs);
+    free(tree->levels[1].pairs);
+}
+
+/**
+ * Parses the graph file into the offsets and children files of the tree, in one sequential pass that keeps all
+ * the validation errors of parseGraphFile that don't need random access. Every edge is written to the spill file
+ * too, as a pair of the child and its parent.
+ * @param argv the arguments that are given to the program
+ * @param uPointer A pointer to the first of the vertices
+ * @param vPointer A pointer to the second of the vertices
+ * @param tree the out of core tree, its files are opened here
+ * @param graphFile the content of the graph file
+ * @param options the options of the program
+ * @return INVALID INPUT enum if the file is not valid, NOT_A_TREE enum if it does not describe a tree,
+ * FILE_WRITE_FAILED or BAD_MEMORY_ALLOCATION enum if the files couldn't be created and VALID_INPUT enum otherwise
+ */
+static enum validityType parseGraphToFiles(char **argv, int *uPointer, int *vPointer, OutOfCoreTree *tree,
+                                           const GraphFile *graphFile, const Options *options)
+{
+    const char *cursor = graphFile->data;
+    const char *end = graphFile->data + graphFile->length;
+    const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+    lineEnd = (lineEnd == NULL) ? end : lineEnd;
+    if (parseNumber(&cursor, lineEnd, INT_MAX, &tree->numOfNodes) == INVALID_INPUT)
+    {
+        return INVALID_INPUT;
+    }
+    while (cursor != lineEnd)
+    {
+        if (!isDelimiter(*cursor++))
+        {
+            return INVALID_INPUT;
+        }
+    }
+    if (processN(argv[2], (int)strlen(argv[2]), uPointer) == INVALID_INPUT ||
+        processN(argv[3], (int)strlen(argv[3]), vPointer) == INVALID_INPUT ||
+        *uPointer >= tree->numOfNodes || *vPointer >= tree->numOfNodes)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType openResult = openOutOfCoreTree(tree, options);
+    if (openResult != VALID_INPUT)
+    {
+        return openResult;
+    }
+    long long n = tree->numOfNodes;
+    long long count_lines = 0;
+    long long numOfEdges = 0;
+    cursor = (lineEnd == end) ? end : lineEnd + 1;
+    while (cursor != end)
+    {
+        lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        lineEnd = (lineEnd == NULL) ? end : lineEnd;
+        if (count_lines == n)
+        {
+            return INVALID_INPUT;
+        }
+        writeInt(&tree->writers[OFFSETS_FILE], (int)numOfEdges);
+        if (cursor != lineEnd && cursor[0] == '-')
+        {
+            if (cursor + 1 != lineEnd && (cursor[1] != '\r' || cursor + 2 != lineEnd))
+            {
+                return INVALID_INPUT;
+            }
+            count_lines++;
+            cursor = (lineEnd == end) ? end : lineEnd + 1;
+            continue;
+        }
+        long long firstEdge = numOfEdges;
+        while (cursor != lineEnd)
+        {
+            if (isDelimiter(*cursor))
+            {
+                cursor++;
+                continue;
+            }
+            Pair edge = {0, (int)count_lines};
+            if (parseNumber(&cursor, lineEnd, tree->numOfNodes, &edge.first) == INVALID_INPUT)
+            {
+                return INVALID_INPUT;
+            }
+            if (numOfEdges >= n - 1)
+            {
+                return NOT_A_TREE;
+            }
+            writeInt(&tree->writers[CHILDREN_FILE], edge.first);
+            writeBytes(&tree->writers[SPILL_FILE], &edge, sizeof(Pair));
+            numOfEdges++;
+        }
+        if (numOfEdges == firstEdge)
+        {
+            return INVALID_INPUT;
+        }
+        count_lines++;
+        cursor = (lineEnd == end) ? end : lineEnd + 1;
+    }
+    if (count_lines != n)
+    {
+        return INVALID_INPUT;
+    }
+    if (numOfEdges != n - 1)
+    {
+        return NOT_A_TREE;
+    }
+    writeInt(&tree->writers[OFFSETS_FILE], (int)numOfEdges);
+    flushWriter(&tree->writers[OFFSETS_FILE]);
+    flushWriter(&tree->writers[CHILDREN_FILE]);
+    flushWriter(&tree->writers[SPILL_FILE]);
+    return streamsResult(tree);
+}
+
+/**
+ * Finds the root by sorting the edges by their children: every node but the root has to be a child exactly
+ * once, so the sorted children are all the keys but the root.
+ * @param tree the out of core tree, its edges are in the spill file
+ * @return NOT_A_TREE enum if a node has two parents, VALID_INPUT enum if the root was found and the problem of
+ * sortPairs otherwise
+ */
+static enum validityType outOfCoreRoot(OutOfCoreTree *tree)
+{
+    long long n = tree->numOfNodes;
+    FileCursor *sorted = &tree->cursors[SORTED_FILE];
+    seekWriter(&tree->writers[SORTED_FILE], 0);
+    enum validityType result = sortPairs(tree, tree->levels[0].pairs, tree->files[SPILL_FILE], n - 1,
+                                         &tree->writers[SORTED_FILE]);
+    flushWriter(&tree->writers[SORTED_FILE]);
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    resetCursor(sorted, tree->files[SORTED_FILE]);
+    tree->root = DEFAULT_PARENT;
+    long long expected = 0;
+    for (long long i = 0; i < n - 1; ++i)
+    {
+        int child = pairAt(sorted, i).first;
+        if (child != expected)
+        {
+            if (tree->root != DEFAULT_PARENT || child != expected + 1)
+            {
+                return NOT_A_TREE;
+            }
+            tree->root = (int)expected++;
+        }
+        expected++;
+    }
+    tree->root = (tree->root == DEFAULT_PARENT) ? (int)(n - 1) : tree->root;
+    return streamsResult(tree);
+}
+
+/**
+ * A BFS from the root that goes level by level. Every level is sorted by key, so the offsets and children of its
+ * nodes are read in order, and the pairs of their children and their positions in the level make the next level.
+ * The levels are written one after the other to the order file and their sizes to the levels file.
+ * @param tree the out of core tree
+ * @param u where the first vertex was found
+ * @param v where the second vertex was found
+ * @param uKey the first vertex
+ * @param vKey the second vertex
+ * @param summary holds the longest and the shortest branches
+ * @return NOT_A_TREE enum if some nodes can't be reached from the root, VALID_INPUT enum if they all were and the
+ * problem of the sort or the files otherwise
+ */
+static enum validityType outOfCoreLevels(OutOfCoreTree *tree, LevelPosition *u, LevelPosition *v, int uKey,
+                                         int vKey, Tree *summary)
+{
+    FileCursor *order = &tree->cursors[ORDER_FILE];
+    FileCursor *offsets = &tree->cursors[OFFSETS_FILE];
+    FileCursor *children = &tree->cursors[CHILDREN_FILE];
+    PairLevel *cur = &tree->levels[0];
+    PairLevel *next = &tree->levels[1];
+    Pair root = {tree->root, NO_PARENT_POSITION};
+    long long levelFirst = 0;
+    long long reached = 1;
+    enum validityType result = VALID_INPUT;
+    clearLevel(cur);
+    addToLevel(tree, cur, root);
+    sortLevel(tree, cur, ORDER_FILE, 1);
+    summary->minBranch = tree->numOfNodes + 1;
+    for (tree->numOfLevels = 0; cur->count > 0 && result == VALID_INPUT; tree->numOfLevels++)
+    {
+        writeInt(&tree->writers[LEVELS_FILE], (int)cur->count);
+        resetCursor(order, tree->files[ORDER_FILE]);
+        clearLevel(next);
+        for (long long i = 0; i < cur->count; ++i)
+        {
+            int key = levelPair(cur, order, i).first;
+            LevelPosition here = {tree->numOfLevels, (int)i, levelFirst, 0};
+            *u = (key == uKey) ? here : *u;
+            *v = (key == vKey) ? here : *v;
+            int firstEdge = intAt(offsets, key);
+            int lastEdge = intAt(offsets, key + 1LL);
+            if (firstEdge == lastEdge && tree->numOfLevels < summary->minBranch)
+            {
+                summary->minBranch = tree->numOfLevels;
+            }
+            for (int edge = firstEdge; edge < lastEdge; ++edge)
+            {
+                Pair child = {intAt(children, edge), (int)i};
+                addToLevel(tree, next, child);
+            }
+        }
+        reached += next->count;
+        levelFirst += cur->count;
+        if (next->count > 0)
+        {
+            result = sortLevel(tree, next, ORDER_FILE, 1);
+        }
+        PairLevel *temp = cur;
+        cur = next;
+        next = temp;
+    }
+    summary->maxBranch = tree->numOfLevels - 1;
+    flushWriter(&tree->writers[ORDER_FILE]);
+    flushWriter(&tree->writers[LEVELS_FILE]);
+    if (result == VALID_INPUT && reached != tree->numOfNodes)
+    {
+        // some nodes are on circles that can't be reached from the root.
+        return NOT_A_TREE;
+    }
+    return (result == VALID_INPUT) ? streamsResult(tree) : result;
+}
+
+/**
+ * Finds the diameter in one pass over the levels from the deepest up. Every node sends the height of its
+ * subtree plus one to the position of its parent, the messages to a level are sorted by position, and the
+ * longest path that turns at a node is the sum of the two largest messages it gets.
+ * @param tree the out of core tree, its levels are in the order file
+ * @param summary holds the diameter
+ * @return VALID_INPUT enum if the diameter was found and the problem of the sort or the files otherwise
+ */
+static enum validityType outOfCoreDiameter(OutOfCoreTree *tree, Tree *summary)
+{
+    FileCursor *order = &tree->cursors[ORDER_FILE];
+    FileCursor *levels = &tree->cursors[LEVELS_FILE];
+    FileCursor *sorted = &tree->cursors[SORTED_FILE];
+    PairLevel *messages = &tree->levels[0];
+    PairLevel *parentMessages = &tree->levels[1];
+    long long levelFirst = tree->numOfNodes;
+    enum validityType result = VALID_INPUT;
+    resetCursor(order, tree->files[ORDER_FILE]);
+    resetCursor(levels, tree->files[LEVELS_FILE]);
+    clearLevel(messages);
+    summary->diameter = 0;
+    for (int level = tree->numOfLevels - 1; level >= 0 && result == VALID_INPUT; --level)
+    {
+        long long levelLen = intAt(levels, level);
+        long long message = 0;
+        levelFirst -= levelLen;
+        resetCursor(sorted, tree->files[SORTED_FILE]);
+        clearLevel(parentMessages);
+        for (long long i = 0; i < levelLen; ++i)
+        {
+            int highest = 0;
+            int secondHighest = 0;
+            for (; message < messages->count; ++message)
+            {
+                Pair pair = levelPair(messages, sorted, message);
+                if (pair.first != i)
+                {
+                    break;
+                }
+                if (pair.second > highest)
+                {
+                    secondHighest = highest;
+                    highest = pair.second;
+                }
+                else if (pair.second > secondHighest)
+                {
+                    secondHighest = pair.second;
+                }
+            }
+            if (highest + secondHighest > summary->diameter)
+            {
+                summary->diameter = highest + secondHighest;
+            }
+            if (level > 0)
+            {
+                Pair toParent = {pairAt(order, levelFirst + i).second, highest + 1};
+                addToLevel(tree, parentMessages, toParent);
+            }
+        }
+        seekWriter(&tree->writers[SORTED_FILE], 0);
+        result = sortLevel(tree, parentMessages, SORTED_FILE, 0);
+        PairLevel *temp = messages;
+        messages = parentMessages;
+        parentMessages = temp;
+    }
+    return (result == VALID_INPUT) ? streamsResult(tree) : result;
+}
+
+/**
+ * Writes a node of the path to the writer of its side and moves to its parent, in the level above.
+ * @param tree the out of core tree
+ * @param cursor the cursor of this side on the order file
+ * @param side where the node is, it is moved to the parent
+ * @param writer the writer of this side of the path
+ */
+static void climbLevel(OutOfCoreTree *tree, FileCursor *cursor, LevelPosition *side, FileWriter *writer)
+{
+    Pair pair = pairAt(cursor, side->levelFirst + side->position);
+    writeInt(writer, pair.first);
+    side->sideLen++;
+    side->position = pair.second;
+    side->level--;
+    side->levelFirst -= intAt(&tree->cursors[LEVELS_FILE], side->level);
+}
+
+/**
+ * Prints the path between u and v, by climbing the levels in the order file from both to their lowest common
+ * ancestor. The u side is written to the spill file and the v side to the sorted file, so v's side is printed
+ * backward.
+ * @param tree the out of core tree
+ * @param u where the first vertex is
+ * @param v where the second vertex is
+ * @return VALID_INPUT enum if the path was printed and FILE_WRITE_FAILED enum if a file couldn't be read or written
+ */
+static enum validityType outOfCorePath(OutOfCoreTree *tree, LevelPosition *u, LevelPosition *v)
+{
+    FileWriter *uWriter = &tree->writers[SPILL_FILE];
+    FileWriter *vWriter = &tree->writers[SORTED_FILE];
+    FileCursor *uCursor = &tree->cursors[ORDER_FILE];
+    resetCursor(uCursor, tree->files[ORDER_FILE]);
+    resetCursor(&tree->pathCursor, tree->files[ORDER_FILE]);
+    resetCursor(&tree->cursors[LEVELS_FILE], tree->files[LEVELS_FILE]);
+    seekWriter(uWriter, 0);
+    seekWriter(vWriter, 0);
+    while (u->level > v->level)
+    {
+        climbLevel(tree, uCursor, u, uWriter);
+    }
+    while (v->level > u->level)
+    {
+        climbLevel(tree, &tree->pathCursor, v, vWriter);
+    }
+    while (u->position != v->position)
+    {
+        climbLevel(tree, uCursor, u, uWriter);
+        climbLevel(tree, &tree->pathCursor, v, vWriter);
+    }
+    int ancestor = pairAt(uCursor, u->levelFirst + u->position).first;
+    flushWriter(uWriter);
+    flushWriter(vWriter);
+    if (streamsResult(tree) != VALID_INPUT)
+    {
+        return FILE_WRITE_FAILED;
+    }
+    resetCursor(&tree->cursors[SPILL_FILE], tree->files[SPILL_FILE]);
+    resetCursor(&tree->cursors[SORTED_FILE], tree->files[SORTED_FILE]);
+    for (long long i = 0; i < u->sideLen; ++i)
+    {
+        printf(" %d", intAt(&tree->cursors[SPILL_FILE], i));
+    }
+    printf(" %d", ancestor);
+    for (long long i = v->sideLen - 1; i >= 0; --i)
+    {
+        printf(" %d", intAt(&tree->cursors[SORTED_FILE], i));
+    }
+    printf("\n");
+    return streamsResult(tree);
+}
+
+/**
+ * Analyzes a tree that may be larger than the memory. The offsets, children and levels of the tree are kept in
+ * files in the out of core directory, and are read and written in order, in passes that hold at most
+ * options->memoryBudget MB of buffers. The tree is validated by the parser, the sort of the children that has to
+ * find every node but the root once and a BFS from the root that has to reach every node.
+ * @param argv the arguments that are given to the program
+ * @param fileP the graph file
+ * @param options the options of the program
+ * @return VALID_INPUT enum if the tree was analyzed and printed, and the problem otherwise
+ */
+enum validityType outOfCoreAnalysis(char **argv, FILE *fileP, const Options *options)
+{
+    OutOfCoreTree tree;
+    GraphFile graphFile;
+    Tree summary;
+    LevelPosition u = {0, 0, 0, 0};
+    LevelPosition v = {0, 0, 0, 0};
+    int uKey, vKey;
+    memset(&tree, 0, sizeof(tree));
+    for (int i = 0; i < NUM_OF_SCRATCH_FILES; ++i)
+    {
+        tree.files[i] = -1;
+    }
+    initiateTree(&summary);
+    if (fileP == NULL)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType result = mapGraphFile(fileP, &graphFile);
+    if (result == VALID_INPUT)
+    {
+        result = parseGraphToFiles(argv, &uKey, &vKey, &tree, &graphFile, options);
+    }
+    unmapGraphFile(&graphFile);
+    if (result == VALID_INPUT)
+    {
+        result = outOfCoreRoot(&tree);
+    }
+    if (result == VALID_INPUT)
+    {
+        result = outOfCoreLevels(&tree, &u, &v, uKey, vKey, &summary);
+    }
+    if (result == VALID_INPUT)
+    {
+        result = outOfCoreDiameter(&tree, &summary);
+    }
+    if (result == VALID_INPUT)
+    {
+        summary.root = tree.root;
+        summary.numOfNodes = tree.numOfNodes;
+        summary.numOfEdges = tree.numOfNodes - 1;
+        treeSummaryPrinter(&summary, stdout);
+        printf("Shortest Path Between %d and %d:", uKey, vKey);
+        result = outOfCorePath(&tree, &u, &v);
+    }
+    closeOutOfCoreTree(&tree);
+    return result;
+}
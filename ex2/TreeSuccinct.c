@@ -0,0 +1,804 @@
+/**
+ * The succinct mode of TreeAnalyzer: the tree is analyzed in its balanced parentheses form, 2n bits with the
+ * small indexes that navigate them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "TreeAnalyzer.h"
+
+#define BITS_IN_WORD 64
+#define NO_POSITION -1
+
+/**
+ * structure that represents the topology of a tree in 2n bits of balanced parentheses: a DFS from the root
+ * writes an open bit (1) when it enters a node and a close bit (0) when it leaves it. A node is the position of
+ * its open bit and its preorder is the number of open bits before it. The excess of a position, the opens
+ * minus the closes up to and including it, is the depth of the node plus one.
+ * The ranks hold the number of open bits before every word, and the minima are a range min tree of the excess
+ * over the words, which finds the next or previous position of a given excess in O(log n).
+ * The keys of the nodes by preorder and the preorders by key are kept only if the keys are not the preorders.
+ */
+typedef struct SuccinctTree
+{
+    int numOfNodes;
+    int numOfWords;
+    int numOfLeaves;
+    long long numOfBits;
+    unsigned long long *words;
+    int *ranks;
+    int *minima;
+    int *keys;
+    int *preorders;
+    Arena arena;
+} SuccinctTree;
+
+/**
+ * structure that represents a tree as the succinct mode parses it, without the nodes of a Tree: the parent of
+ * every node, and the children of node i in children[offsets[i]] to children[offsets[i + 1] - 1].
+ * All the arrays are taken from the arena of the tree, which is released once the bits are built.
+ */
+typedef struct ParentTree
+{
+    int numOfNodes;
+    int numOfEdges;
+    int root;
+    long long childrenKeysSum;
+    int *parents;
+    int *offsets;
+    int *children;
+    Arena arena;
+} ParentTree;
+
+/**
+ * Carves the arrays of the parsed tree from an arena.
+ * @param tree the parsed tree, with its number of nodes set
+ * @param arena the arena
+ * @return 1 if the arrays were carved and 0 if the arena is too small or only measures
+ */
+static int carveParentTree(ParentTree *tree, Arena *arena)
+{
+    size_t n = (size_t)tree->numOfNodes;
+    tree->parents = (int *)arenaAlloc(arena, sizeof(int) * n);
+    tree->offsets = (int *)arenaAlloc(arena, sizeof(int) * (n + 1));
+    tree->children = (int *)arenaAlloc(arena, sizeof(int) * n);
+    return tree->parents != NULL && tree->offsets != NULL && tree->children != NULL;
+}
+
+/**
+ * Checks the vertices given as arguments against the number of vertices, and allocates the parsed tree with
+ * no edges.
+ * @param argv the given arguments, the vertices are argv[2] and argv[3]
+ * @param uPointer holds the first vertex
+ * @param vPointer holds the second vertex
+ * @param tree the parsed tree, with its number of nodes set
+ * @return INVALID_INPUT enum if a vertex is not valid, BAD_MEMORY_ALLOCATION enum if the tree couldn't be
+ * allocated and VALID_INPUT enum otherwise
+ */
+static enum validityType prepareParentTree(char **argv, int *uPointer, int *vPointer, ParentTree *tree)
+{
+    Arena counter = {NULL, 0, 0};
+    if (processN(argv[2], (int)strlen(argv[2]), uPointer) == INVALID_INPUT ||
+        processN(argv[3], (int)strlen(argv[3]), vPointer) == INVALID_INPUT ||
+        *uPointer >= tree->numOfNodes || *vPointer >= tree->numOfNodes)
+    {
+        return INVALID_INPUT;
+    }
+    carveParentTree(tree, &counter);
+    tree->arena.capacity = counter.used;
+    tree->arena.used = 0;
+    tree->arena.memory = (char *)malloc(counter.used);
+    if (tree->arena.memory == NULL)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    carveParentTree(tree, &tree->arena);
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        tree->parents[i] = DEFAULT_PARENT;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Sets the parent of a node, as linkChild does but for the circles, which are found by the walk from the root.
+ * @param tree the parsed tree
+ * @param parentKey the parent, DEFAULT_PARENT for a root
+ * @param sonKey the child
+ * @return NOT_A_TREE enum if the node already has a parent or there are too many edges and VALID_INPUT enum
+ * otherwise
+ */
+static enum validityType addParent(ParentTree *tree, int parentKey, int sonKey)
+{
+    if (parentKey == DEFAULT_PARENT)
+    {
+        return VALID_INPUT;
+    }
+    if (tree->numOfEdges >= tree->numOfNodes - 1 || tree->parents[sonKey] != DEFAULT_PARENT)
+    {
+        return NOT_A_TREE;
+    }
+    tree->parents[sonKey] = parentKey;
+    tree->numOfEdges++;
+    tree->childrenKeysSum += sonKey;
+    return VALID_INPUT;
+}
+
+/**
+ * Parses the lines of a child list, which already groups the children by their parents, straight into the
+ * children and the offsets, as parseGraphFile checks them.
+ * @param tree the parsed tree, prepared
+ * @param cursor the first char of the second line of the file
+ * @param end the end of the file
+ * @return INVALID_INPUT enum if a line is not valid, NOT_A_TREE enum if the lines can't describe a tree and
+ * VALID_INPUT enum otherwise
+ */
+static enum validityType parseChildLines(ParentTree *tree, const char *cursor, const char *end)
+{
+    int count_lines = 0;
+    while (cursor != end)
+    {
+        const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        lineEnd = (lineEnd == NULL) ? end : lineEnd;
+        if (count_lines == tree->numOfNodes)
+        {
+            return INVALID_INPUT;
+        }
+        int numOfChildren;
+        int *children = tree->children + tree->numOfEdges;
+        enum validityType result = scanChildren(cursor, lineEnd, tree->numOfNodes, children,
+                                                tree->numOfNodes - 1 - tree->numOfEdges, &numOfChildren);
+        tree->offsets[count_lines] = tree->numOfEdges;
+        for (int i = 0; result == VALID_INPUT && i < numOfChildren; ++i)
+        {
+            result = addParent(tree, count_lines, children[i]);
+        }
+        if (result != VALID_INPUT)
+        {
+            return result;
+        }
+        count_lines++;
+        cursor = (lineEnd == end) ? end : lineEnd + 1;
+    }
+    tree->offsets[tree->numOfNodes] = tree->numOfEdges;
+    return (count_lines == tree->numOfNodes) ? VALID_INPUT : INVALID_INPUT;
+}
+
+/**
+ * Parses the lines of an edge list or a parent array in text into the parents, as parseKeysFile checks them.
+ * @param tree the parsed tree, prepared
+ * @param cursor the first char of the second line of the file
+ * @param end the end of the file
+ * @param isParentArray 1 for a parent array and 0 for an edge list
+ * @return INVALID_INPUT enum if a line is not valid, NOT_A_TREE enum if the lines can't describe a tree and
+ * VALID_INPUT enum otherwise
+ */
+static enum validityType parseKeyLines(ParentTree *tree, const char *cursor, const char *end,
+                                       int isParentArray)
+{
+    int numOfLines = isParentArray ? tree->numOfNodes : tree->numOfNodes - 1;
+    int count = 0;
+    int keys[2];
+    enum validityType result = VALID_INPUT;
+    while (result == VALID_INPUT && cursor != end)
+    {
+        const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        lineEnd = (lineEnd == NULL) ? end : lineEnd;
+        if (count == numOfLines ||
+            parseKeysLine(cursor, lineEnd, tree->numOfNodes, isParentArray ? 1 : 2, keys) == INVALID_INPUT ||
+            (!isParentArray && (keys[0] < 0 || keys[1] < 0)))
+        {
+            return INVALID_INPUT;
+        }
+        result = isParentArray ? addParent(tree, keys[0], count) : addParent(tree, keys[0], keys[1]);
+        count++;
+        cursor = (lineEnd == end) ? end : lineEnd + 1;
+    }
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    return (count == numOfLines) ? VALID_INPUT : INVALID_INPUT;
+}
+
+/**
+ * Parses the keys of a binary edge list or parent array into the parents, as parseBinaryFile checks them.
+ * @param tree the parsed tree, prepared
+ * @param keys the keys after the number of vertices
+ * @param numOfKeys the number of keys
+ * @param isParentArray 1 for a parent array and 0 for an edge list
+ * @return INVALID_INPUT enum if a key is not valid, NOT_A_TREE enum if the keys can't describe a tree and
+ * VALID_INPUT enum otherwise
+ */
+static enum validityType parseBinaryKeys(ParentTree *tree, const char *keys, long long numOfKeys,
+                                         int isParentArray)
+{
+    enum validityType result = VALID_INPUT;
+    for (long long i = 0; result == VALID_INPUT && i < numOfKeys; i += isParentArray ? 1 : 2)
+    {
+        int parentKey = readLittleEndian(keys + i * KEY_BYTES);
+        int sonKey = isParentArray ? (int)i : readLittleEndian(keys + (i + 1) * KEY_BYTES);
+        if (parentKey < DEFAULT_PARENT || parentKey >= tree->numOfNodes || sonKey < 0 ||
+            sonKey >= tree->numOfNodes || (!isParentArray && parentKey == DEFAULT_PARENT))
+        {
+            return INVALID_INPUT;
+        }
+        result = addParent(tree, parentKey, sonKey);
+    }
+    return result;
+}
+
+/**
+ * Places the children of every node after the children of the nodes before it, by a counting sort of the
+ * parents, as buildChildren does.
+ * @param tree the parsed tree, with the parent of every node set
+ */
+static void placeChildren(ParentTree *tree)
+{
+    for (int i = 0; i <= tree->numOfNodes; ++i)
+    {
+        tree->offsets[i] = 0;
+    }
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        if (tree->parents[i] != DEFAULT_PARENT)
+        {
+            tree->offsets[tree->parents[i] + 1]++;
+        }
+    }
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        tree->offsets[i + 1] += tree->offsets[i];
+    }
+    for (int i = 0; i < tree->numOfNodes; ++i)
+    {
+        if (tree->parents[i] != DEFAULT_PARENT)
+        {
+            tree->children[tree->offsets[tree->parents[i]]++] = i;
+        }
+    }
+    // every offset moved to the end of its range, which is the start of the next one.
+    for (int i = tree->numOfNodes; i > 0; --i)
+    {
+        tree->offsets[i] = tree->offsets[i - 1];
+    }
+    tree->offsets[0] = 0;
+}
+
+/**
+ * Parses the graph file of the succinct mode, in any of the formats and with the checks of the parsers of
+ * TreeAnalyzer.c, into the parents and the children of the nodes. The circles are found later, by the walk
+ * from the root.
+ * @param argv the arguments that are given to the program
+ * @param uPointer holds the first vertex
+ * @param vPointer holds the second vertex
+ * @param tree holds the parsed tree, its arena is allocated here
+ * @param graphFile the content of the file
+ * @param format the format of the file
+ * @return INVALID_INPUT enum if the input is not valid, NOT_A_TREE enum if it is not a tree,
+ * BAD_MEMORY_ALLOCATION enum if the tree couldn't be allocated and VALID_INPUT enum otherwise
+ */
+static enum validityType parseParentTree(char **argv, int *uPointer, int *vPointer, ParentTree *tree,
+                                         const GraphFile *graphFile, enum inputFormat format)
+{
+    const char *cursor = graphFile->data;
+    const char *end = graphFile->data + graphFile->length;
+    const char *lineEnd = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+    lineEnd = (lineEnd == NULL) ? end : lineEnd;
+    int isBinary = format == BINARY_EDGE_LIST_FORMAT || format == BINARY_PARENT_ARRAY_FORMAT;
+    int isParentArray = format == PARENT_ARRAY_FORMAT || format == BINARY_PARENT_ARRAY_FORMAT;
+    long long numOfKeys = 0;
+    if (isBinary)
+    {
+        if (graphFile->length < KEY_BYTES || (tree->numOfNodes = readLittleEndian(cursor)) < 0)
+        {
+            return INVALID_INPUT;
+        }
+        numOfKeys = isParentArray ? tree->numOfNodes : 2LL * (tree->numOfNodes - 1);
+        if (numOfKeys < 0 || graphFile->length != (size_t)(numOfKeys + 1) * KEY_BYTES)
+        {
+            return INVALID_INPUT;
+        }
+    }
+    else if (format == CHILD_LIST_FORMAT)
+    {
+        if (parseNumber(&cursor, lineEnd, INT_MAX, &tree->numOfNodes) == INVALID_INPUT)
+        {
+            return INVALID_INPUT;
+        }
+        while (cursor != lineEnd)
+        {
+            if (!isDelimiter(*cursor++))
+            {
+                return INVALID_INPUT;
+            }
+        }
+    }
+    else if (parseKeysLine(cursor, lineEnd, INT_MAX, 1, &tree->numOfNodes) == INVALID_INPUT ||
+             tree->numOfNodes < 0)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType result = prepareParentTree(argv, uPointer, vPointer, tree);
+    cursor = (lineEnd == end) ? end : lineEnd + 1;
+    if (result == VALID_INPUT)
+    {
+        if (isBinary)
+        {
+            result = parseBinaryKeys(tree, graphFile->data + KEY_BYTES, numOfKeys, isParentArray);
+        }
+        else
+        {
+            result = (format == CHILD_LIST_FORMAT) ? parseChildLines(tree, cursor, end)
+                                                   : parseKeyLines(tree, cursor, end, isParentArray);
+        }
+    }
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    if (tree->numOfEdges != tree->numOfNodes - 1)
+    {
+        return NOT_A_TREE;
+    }
+    if (format != CHILD_LIST_FORMAT)
+    {
+        placeChildren(tree);
+    }
+    // every node but the root is a child exactly once, so the root is the only key missing from the sum.
+    tree->root = (int)((long long)tree->numOfNodes * (tree->numOfNodes - 1) / 2 - tree->childrenKeysSum);
+    return VALID_INPUT;
+}
+
+/**
+ * Walks the parsed tree in preorder from its root. The parents are not needed once the children are placed,
+ * so they hold the stack of the walk: entry d is the next edge of the node at depth d, and that node is the
+ * child on the edge before the next edge of depth d - 1.
+ * @param tree the parsed tree
+ * @param words if not NULL, zeroed words that get an open bit for every node entered, the close bits are 0
+ * @param keys if not NULL, holds the key of every node by its preorder
+ * @param inPreorder holds 1 if the key of every node is its preorder and 0 otherwise
+ * @return the number of nodes reached, less than the number of nodes if some of them are on circles
+ */
+static int parentTreeWalk(ParentTree *tree, unsigned long long *words, int *keys, int *inPreorder)
+{
+    int *stack = tree->parents;
+    int top = 0;
+    int preorder = 0;
+    long long position = 0;
+    int key = tree->root;
+    *inPreorder = 1;
+    while (1)
+    {
+        // the node is entered.
+        if (words != NULL)
+        {
+            words[position / BITS_IN_WORD] |= 1ULL << (unsigned int)(position % BITS_IN_WORD);
+        }
+        if (keys != NULL)
+        {
+            keys[preorder] = key;
+        }
+        *inPreorder = *inPreorder && key == preorder;
+        preorder++;
+        position++;
+        stack[top++] = tree->offsets[key];
+        // the nodes that have no more children are left.
+        int node = key;
+        while (stack[top - 1] == tree->offsets[node + 1])
+        {
+            top--;
+            position++;
+            if (top == 0)
+            {
+                return preorder;
+            }
+            node = (top == 1) ? tree->root : tree->children[stack[top - 2] - 1];
+        }
+        key = tree->children[stack[top - 1]++];
+    }
+}
+
+/**
+ * Carves the arrays of the balanced parentheses form from an arena.
+ * @param succinct the form, with its sizes set
+ * @param withKeys 1 if the keys of the nodes are not their preorders
+ * @param arena the arena
+ * @return 1 if the arrays were carved and 0 if the arena is too small or only measures
+ */
+static int carveSuccinctTree(SuccinctTree *succinct, int withKeys, Arena *arena)
+{
+    size_t labelsLen = sizeof(int) * (size_t)succinct->numOfNodes;
+    succinct->words = (unsigned long long *)arenaAlloc(arena, sizeof(unsigned long long) *
+                                                              (size_t)succinct->numOfWords);
+    succinct->ranks = (int *)arenaAlloc(arena, sizeof(int) * (size_t)succinct->numOfWords);
+    succinct->minima = (int *)arenaAlloc(arena, 2 * sizeof(int) * (size_t)succinct->numOfLeaves);
+    succinct->keys = withKeys ? (int *)arenaAlloc(arena, labelsLen) : NULL;
+    succinct->preorders = withKeys ? (int *)arenaAlloc(arena, labelsLen) : NULL;
+    return succinct->words != NULL && succinct->ranks != NULL && succinct->minima != NULL &&
+           (!withKeys || (succinct->keys != NULL && succinct->preorders != NULL));
+}
+
+/**
+ * Builds the balanced parentheses form of the parsed tree, with the ranks and the range min tree of the excess.
+ * A first walk checks the tree has no circles, a second one writes the bits.
+ * @param tree the parsed tree
+ * @param succinct holds the balanced parentheses form
+ * @return NOT_A_TREE enum if some nodes are on circles, BAD_MEMORY_ALLOCATION enum if there is no memory for
+ * the form and VALID_INPUT enum otherwise
+ */
+static enum validityType buildSuccinctTree(ParentTree *tree, SuccinctTree *succinct)
+{
+    Arena counter = {NULL, 0, 0};
+    int inPreorder;
+    if (parentTreeWalk(tree, NULL, NULL, &inPreorder) != tree->numOfNodes)
+    {
+        return NOT_A_TREE;
+    }
+    succinct->numOfNodes = tree->numOfNodes;
+    succinct->numOfBits = 2 * (long long)tree->numOfNodes;
+    succinct->numOfWords = (int)((succinct->numOfBits + BITS_IN_WORD - 1) / BITS_IN_WORD);
+    succinct->numOfLeaves = 1;
+    while (succinct->numOfLeaves < succinct->numOfWords)
+    {
+        succinct->numOfLeaves *= 2;
+    }
+    carveSuccinctTree(succinct, !inPreorder, &counter);
+    succinct->arena.capacity = counter.used;
+    succinct->arena.used = 0;
+    succinct->arena.memory = (char *)malloc(counter.used);
+    if (succinct->arena.memory == NULL)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    carveSuccinctTree(succinct, !inPreorder, &succinct->arena);
+    memset(succinct->words, 0, sizeof(unsigned long long) * (size_t)succinct->numOfWords);
+    parentTreeWalk(tree, succinct->words, succinct->keys, &inPreorder);
+    for (int i = 0; succinct->keys != NULL && i < succinct->numOfNodes; ++i)
+    {
+        succinct->preorders[succinct->keys[i]] = i;
+    }
+    int ones = 0;
+    int excess = 0;
+    for (int w = 0; w < succinct->numOfLeaves; ++w)
+    {
+        int minimum = INT_MAX;
+        if (w < succinct->numOfWords)
+        {
+            succinct->ranks[w] = ones;
+            ones += __builtin_popcountll(succinct->words[w]);
+        }
+        for (long long i = (long long)w * BITS_IN_WORD;
+             i < (long long)(w + 1) * BITS_IN_WORD && i < succinct->numOfBits; ++i)
+        {
+            excess += ((succinct->words[w] >> (unsigned int)(i % BITS_IN_WORD)) & 1u) ? 1 : -1;
+            minimum = (excess < minimum) ? excess : minimum;
+        }
+        succinct->minima[succinct->numOfLeaves + w] = minimum;
+    }
+    for (int node = succinct->numOfLeaves - 1; node > 0; --node)
+    {
+        int left = succinct->minima[2 * node];
+        int right = succinct->minima[2 * node + 1];
+        succinct->minima[node] = (left < right) ? left : right;
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Releases the balanced parentheses form of a tree.
+ * @param succinct the form to release
+ */
+static void freeSuccinctTree(SuccinctTree *succinct)
+{
+    free(succinct->arena.memory);
+    succinct->arena.memory = NULL;
+}
+
+/**
+ * Checks if a position holds an open bit.
+ * @param succinct the balanced parentheses form
+ * @param i the position
+ * @return 1 if the bit is open and 0 otherwise
+ */
+static inline int isOpen(const SuccinctTree *succinct, long long i)
+{
+    return (int)((succinct->words[i / BITS_IN_WORD] >> (unsigned int)(i % BITS_IN_WORD)) & 1u);
+}
+
+/**
+ * Counts the open bits before a position.
+ * @param succinct the balanced parentheses form
+ * @param i the position, at most the number of bits
+ * @return the number of open bits in positions 0 to i - 1
+ */
+static long long succinctRank(const SuccinctTree *succinct, long long i)
+{
+    long long word = i / BITS_IN_WORD;
+    if (word == succinct->numOfWords)
+    {
+        return succinct->numOfNodes;
+    }
+    unsigned long long below = (1ULL << (unsigned int)(i % BITS_IN_WORD)) - 1;
+    return succinct->ranks[word] + __builtin_popcountll(succinct->words[word] & below);
+}
+
+/**
+ * Calculates the excess of a position, the open bits minus the close bits up to and including it.
+ * @param succinct the balanced parentheses form
+ * @param i the position
+ * @return the excess
+ */
+static int excessAt(const SuccinctTree *succinct, long long i)
+{
+    return (int)(2 * succinctRank(succinct, i + 1) - (i + 1));
+}
+
+/**
+ * Finds the position of the open bit of the node of the given preorder, by a binary search of the ranks.
+ * @param succinct the balanced parentheses form
+ * @param preorder the preorder of the node
+ * @return the position of the node
+ */
+static long long succinctSelect(const SuccinctTree *succinct, int preorder)
+{
+    int low = 0;
+    int high = succinct->numOfWords - 1;
+    while (low < high)
+    {
+        int middle = low + (high - low + 1) / 2;
+        if (succinct->ranks[middle] <= preorder)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    unsigned long long word = succinct->words[low];
+    for (int k = preorder - succinct->ranks[low]; k > 0; --k)
+    {
+        word &= word - 1;
+    }
+    return (long long)low * BITS_IN_WORD + __builtin_ctzll(word);
+}
+
+/**
+ * Finds the last position before i whose excess is at most the target, the target being below the excess of
+ * i. The excess moves by one at every position, so the excess of the found position is the target. The
+ * start of the word of i is scanned, then the range min tree finds the last word before it that gets down to
+ * the target.
+ * @param succinct the balanced parentheses form
+ * @param i the position to search before
+ * @param target the excess
+ * @return the position, NO_POSITION if there is none (the excess before position 0 is 0)
+ */
+static long long backwardSearch(const SuccinctTree *succinct, long long i, int target)
+{
+    int excess = excessAt(succinct, i);
+    long long j = i;
+    while (j % BITS_IN_WORD != 0)
+    {
+        excess -= isOpen(succinct, j) ? 1 : -1;
+        j--;
+        if (excess <= target)
+        {
+            return j;
+        }
+    }
+    if (j == 0)
+    {
+        return NO_POSITION;
+    }
+    long long node = succinct->numOfLeaves + j / BITS_IN_WORD - 1;
+    while (succinct->minima[node] > target)
+    {
+        // to the previous node on the same level, up while the node is a left child.
+        while (node % 2 == 0)
+        {
+            node /= 2;
+        }
+        if (node == 1)
+        {
+            return NO_POSITION;
+        }
+        node--;
+    }
+    while (node < succinct->numOfLeaves)
+    {
+        node = (succinct->minima[2 * node + 1] <= target) ? 2 * node + 1 : 2 * node;
+    }
+    j = (node - succinct->numOfLeaves + 1) * BITS_IN_WORD - 1;
+    j = (j < succinct->numOfBits) ? j : succinct->numOfBits - 1;
+    excess = excessAt(succinct, j);
+    while (excess > target)
+    {
+        excess -= isOpen(succinct, j) ? 1 : -1;
+        j--;
+    }
+    return j;
+}
+
+/**
+ * Finds the parent of a node, the last open bit before it with one less excess.
+ * @param succinct the balanced parentheses form
+ * @param i the position of the node
+ * @return the position of the parent, NO_POSITION for the root
+ */
+static long long succinctParent(const SuccinctTree *succinct, long long i)
+{
+    int excess = excessAt(succinct, i);
+    if (excess == 1)
+    {
+        return NO_POSITION;
+    }
+    return backwardSearch(succinct, i, excess - 2) + 1;
+}
+
+/**
+ * Calculates the depth of a node.
+ * @param succinct the balanced parentheses form
+ * @param i the position of the node
+ * @return the depth, 0 for the root
+ */
+static int succinctDepth(const SuccinctTree *succinct, long long i)
+{
+    return excessAt(succinct, i) - 1;
+}
+
+/**
+ * Finds the key of a node.
+ * @param succinct the balanced parentheses form
+ * @param i the position of the node
+ * @return the key
+ */
+static int succinctKey(const SuccinctTree *succinct, long long i)
+{
+    int preorder = (int)succinctRank(succinct, i);
+    return (succinct->keys != NULL) ? succinct->keys[preorder] : preorder;
+}
+
+/**
+ * Calculates the branch lengths and the diameter of the tree in one scan of the bits. A leaf is an open bit
+ * followed by a close bit, and the longest branch is the highest excess less one. Between the positions a and
+ * b the lowest excess belongs to their lowest common ancestor, so the diameter is the largest
+ * excess(a) - 2 * excess(k) + excess(b) over a <= k <= b, kept by the highest excess so far and the highest
+ * excess(a) - 2 * excess(k) so far, as the Euler tour of the dynamic mode does.
+ * @param succinct the balanced parentheses form
+ * @param summary holds the branch lengths and the diameter
+ */
+static void succinctBranches(const SuccinctTree *succinct, Tree *summary)
+{
+    int excess = 0;
+    int highest = INT_MIN;
+    int bestLeft = INT_MIN;
+    summary->diameter = 0;
+    summary->maxBranch = 0;
+    summary->minBranch = succinct->numOfNodes + 1;
+    for (long long i = 0; i < succinct->numOfBits; ++i)
+    {
+        int open = isOpen(succinct, i);
+        if (!open && isOpen(succinct, i - 1) && excess - 1 < summary->minBranch)
+        {
+            summary->minBranch = excess - 1;
+        }
+        excess += open ? 1 : -1;
+        if (i == succinct->numOfBits - 1)
+        {
+            // the close bit of the root is above the root, it is not on any path.
+            break;
+        }
+        highest = (excess > highest) ? excess : highest;
+        bestLeft = (highest - 2 * excess > bestLeft) ? highest - 2 * excess : bestLeft;
+        summary->diameter = (bestLeft + excess > summary->diameter) ? bestLeft + excess : summary->diameter;
+        summary->maxBranch = (excess - 1 > summary->maxBranch) ? excess - 1 : summary->maxBranch;
+    }
+}
+
+/**
+ * Creates the path between u and v from the balanced parentheses form, going up from both to their lowest
+ * common ancestor by the parent search. The path is kept from its end as diameterAndPath keeps it.
+ * @param succinct the balanced parentheses form
+ * @param uKey the first vertex
+ * @param vKey the second vertex
+ * @param summary holds the path, which the caller has to free
+ * @return BAD_MEMORY_ALLOCATION enum if there is no memory for the path and VALID_INPUT enum otherwise
+ */
+static enum validityType succinctPath(const SuccinctTree *succinct, int uKey, int vKey, Tree *summary)
+{
+    long long u = succinctSelect(succinct, (succinct->keys != NULL) ? succinct->preorders[uKey] : uKey);
+    long long v = succinctSelect(succinct, (succinct->keys != NULL) ? succinct->preorders[vKey] : vKey);
+    int uDepth = succinctDepth(succinct, u);
+    int vDepth = succinctDepth(succinct, v);
+    long long uAncestor = u;
+    long long vAncestor = v;
+    for (int depth = uDepth; depth > vDepth; --depth)
+    {
+        uAncestor = succinctParent(succinct, uAncestor);
+    }
+    for (int depth = vDepth; depth > uDepth; --depth)
+    {
+        vAncestor = succinctParent(succinct, vAncestor);
+    }
+    while (uAncestor != vAncestor)
+    {
+        uAncestor = succinctParent(succinct, uAncestor);
+        vAncestor = succinctParent(succinct, vAncestor);
+    }
+    int ancestorDepth = succinctDepth(succinct, uAncestor);
+    int vSideLen = vDepth - ancestorDepth;
+    summary->pathLen = vSideLen + (uDepth - ancestorDepth) + 1;
+    summary->path = (int *)malloc(sizeof(int) * (size_t)summary->pathLen);
+    if (summary->path == NULL)
+    {
+        return BAD_MEMORY_ALLOCATION;
+    }
+    int i = 0;
+    for (long long curNode = v; curNode != vAncestor; curNode = succinctParent(succinct, curNode))
+    {
+        summary->path[i++] = succinctKey(succinct, curNode);
+    }
+    summary->path[vSideLen] = succinctKey(succinct, vAncestor);
+    i = summary->pathLen - 1;
+    for (long long curNode = u; curNode != uAncestor; curNode = succinctParent(succinct, curNode))
+    {
+        summary->path[i--] = succinctKey(succinct, curNode);
+    }
+    return VALID_INPUT;
+}
+
+/**
+ * Analyzes the tree in its balanced parentheses form. The graph file is parsed into the parents and the
+ * children alone, without the nodes of a Tree, the form is built from them and they are released, and the
+ * branches, the diameter and the path are found from the 2n bits.
+ * @param argv the arguments that are given to the program
+ * @param fileP the graph file
+ * @param options the options of the program
+ * @return VALID_INPUT enum if the tree was analyzed and printed, and the problem otherwise
+ */
+enum validityType succinctAnalysis(char **argv, FILE *fileP, const Options *options)
+{
+    ParentTree tree;
+    SuccinctTree succinct;
+    GraphFile graphFile;
+    Tree summary;
+    int uKey, vKey;
+    tree.numOfEdges = 0;
+    tree.childrenKeysSum = 0;
+    tree.arena.memory = NULL;
+    succinct.arena.memory = NULL;
+    initiateTree(&summary);
+    if (fileP == NULL)
+    {
+        return INVALID_INPUT;
+    }
+    enum validityType result = mapGraphFile(fileP, &graphFile);
+    if (result == VALID_INPUT)
+    {
+        result = parseParentTree(argv, &uKey, &vKey, &tree, &graphFile, options->inputFormat);
+    }
+    unmapGraphFile(&graphFile);
+    if (result == VALID_INPUT)
+    {
+        result = buildSuccinctTree(&tree, &succinct);
+    }
+    free(tree.arena.memory);
+    if (result != VALID_INPUT)
+    {
+        return result;
+    }
+    summary.numOfNodes = succinct.numOfNodes;
+    summary.numOfEdges = succinct.numOfNodes - 1;
+    summary.root = succinctKey(&succinct, 0);
+    succinctBranches(&succinct, &summary);
+    result = succinctPath(&succinct, uKey, vKey, &summary);
+    if (result == VALID_INPUT)
+    {
+        treePrinter(&summary, uKey, vKey, stdout);
+    }
+    free(summary.path);
+    freeSuccinctTree(&succinct);
+    return result;
+}
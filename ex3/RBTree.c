@@ -1,397 +1,1658 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
 #include "RBTree.h"
+#include "RBTreeOptions.h"
+
+#define SLAB_BLOCK_NODES 1024
+#define INSERTION_SORT_LEN 16
+#define PARALLEL_SORT_MIN 16384
+#define MAX_SORT_DEPTH 4
+#define CACHE_LINE_SIZE 64
+#define READER_SLOTS 128
+#define READ_RETRIES 16
+#define READ_CHUNK_LEN 64
+#define BACKOFF_YIELDS 16
+#define BACKOFF_MIN_NS 1000
+#define BACKOFF_MAX_NS 1000000
+#define RECLAIM_BATCH 64
+#define BTREE_NODE_SIZE 256
+#define BTREE_LEAF_KEYS 30
+#define BTREE_INNER_KEYS 15
+
 void case3(Node *newNode, RBTree *tree);
 void case4(Node *newNode, RBTree* tree);
+Node* findLeaf(Node *node);
+Node *returnNodesInOrder(Node *node);
+void initNode(void *data, Node *newNode);
 
 /**
- * constructs a new RBTree with the given CompareFunc.
- * comp: a function two compare two variables.
+ * a node of a tree with order statistics, that also holds the number of nodes in its subtree.
  */
-RBTree *newRBTree(CompareFunc compFunc, FreeFunc freeFunc)
+typedef struct TreeNode
 {
-	RBTree *newTree = (RBTree*)malloc(sizeof(RBTree));
-    newTree->root = NULL;
-    newTree->compFunc = compFunc;
-    newTree->freeFunc = freeFunc;
-    newTree->size = 0;
-	return newTree;
-}
+    Node node;
+    int subtreeSize;
+} TreeNode;
 
 /**
- * a function that returns the given node parent.
- * @param node: the node.
- * @return the node's parent
+ * a block of nodes of the slab allocator, the nodes of a tree are handed out from its blocks in order.
+ * the nodes are Nodes or TreeNodes, by the options of the tree.
  */
-Node* findNodeParent(Node *node)
+typedef struct SlabBlock
 {
-    if (node->parent == NULL)
-    {
-        return NULL;
-    }
-    else
-    {
-        return node->parent;
-    }
-}
+    struct SlabBlock *next;
+    TreeNode nodes[];
+} SlabBlock;
 
 /**
- * a function that returns the given node's grandParent.
- * @param node: the node.
- * @return the node's grandpa
+ * the slot of an active reader of a concurrent tree, holding the epoch the reader started in (0 for a free
+ * slot). every slot has its own cache line so the readers don't share lines.
  */
-Node* findGrandParent(Node *node)
+typedef struct ReaderSlot
 {
-    return findNodeParent(node->parent);
-}
+    unsigned long epoch;
+    char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+} ReaderSlot;
 
 /**
- * a function that returns the given node's uncle.
- * @param node: the node.
- * @return the node's uncle
+ * an item removed from a concurrent tree, that is freed when no reader of its epoch is left.
  */
-Node* findNodeUncle(Node *node)
+typedef struct RetiredItem
 {
-    int isRightNode = 0;
-    if (findNodeParent(node) != NULL && findGrandParent(node) != NULL)
-    {
-        if (node->parent == findGrandParent(node)->left)
-        {
-            isRightNode = 1;
-        }
-        else
-        {
-            isRightNode = 0;
-        }
-    }
-    else
-    {
-        return NULL;
-    }
-    if(isRightNode)
-    {
-        return findGrandParent(node)->right;
-    }
-    return findGrandParent(node)->left;
-}
+    void *data;
+    unsigned long epoch;
+} RetiredItem;
 
 /**
- * a function that initiate a left rotate on a given tree, from the given node.
- * @param node the node to do the rotation from.
- * @param tree the tree to make the rotation on.
+ * the state of a concurrent tree. the writers take the lock and make the sequence odd while they change the
+ * tree, the readers take no lock: they walk the tree and check that the sequence didn't change on the way.
+ * the removed items are freed only when every reader that could hold them is done (epoch based reclamation).
  */
-void rotateLeft(Node *node, RBTree* tree)
+typedef struct ConcurrentState
 {
-    Node *temp = node->right;
-    if(temp == NULL)
+    ReaderSlot readers[READER_SLOTS];
+    unsigned long sequence;
+    unsigned long epoch;
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(unsigned long)];
+    pthread_mutex_t writer;
+    RetiredItem *retired;
+    int numOfRetired;
+    int retiredCapacity;
+} ConcurrentState;
+
+/**
+ * the start of a node of a B+-tree, every node takes BTREE_NODE_SIZE bytes (four cache lines with 64 bit
+ * pointers) and starts at a cache line.
+ */
+typedef struct BTreeNode
+{
+    int numOfKeys;
+    int isLeaf;
+} BTreeNode;
+
+/**
+ * a leaf of a B+-tree, all the items are in the leaves and the leaves are linked in order.
+ */
+typedef struct BTreeLeaf
+{
+    BTreeNode header;
+    struct BTreeLeaf *next;
+    void *keys[BTREE_LEAF_KEYS];
+} BTreeLeaf;
+
+/**
+ * an inner node of a B+-tree, keys[i] is the first item under children[i + 1].
+ */
+typedef struct BTreeInner
+{
+    BTreeNode header;
+    void *keys[BTREE_INNER_KEYS];
+    BTreeNode *children[BTREE_INNER_KEYS + 1];
+} BTreeInner;
+
+/**
+ * the state of a tree besides the RBTree itself. every tree is allocated as a TreeState, so a tree can
+ * always be cast to its state.
+ */
+typedef struct TreeState
+{
+    RBTree tree;
+    int options;
+    size_t nodeSize;
+    SlabBlock *blocks;
+    int blockUsed;
+    Node *freeNodes;
+    ConcurrentState *concurrent;
+    BTreeNode *btreeRoot;
+    int btreeHeight;
+    BTreeLeaf *spareNodes;
+    int numOfSpareNodes;
+} TreeState;
+
+/**
+ * constructs a new RBTree with the given CompareFunc and options.
+ * @param compFunc a function two compare two variables.
+ * @param freeFunc a function to free a variable.
+ * @param options RBTREE_SLAB_NODES to take the nodes from large blocks of the tree instead of a malloc for
+ * every node, RBTREE_ORDER_STATISTICS to keep the size of the subtree of every node for rankOfRBTree and
+ * selectKthRBTree, RBTREE_CONCURRENT for a tree that many threads read while one thread at a time writes, any of
+ * them or-ed, or 0.
+ * in a concurrent tree containsRBTree and forEachRBTree take no lock and run along the writers
+ * (addToRBTree, insertOrFindRBTree, removeFromRBTree and deleteFromRBTree), the other functions must not run
+ * along a writer. the compare function must be safe to run along the writers, and the functions of a reader
+ * must not write to the same tree.
+ * RBTREE_BTREE keeps the items in a B+-tree of cache line sized nodes instead of a red black tree, for faster
+ * lookups and scans of large trees. it goes with no other option, and supports addToRBTree, containsRBTree,
+ * forEachRBTree and freeRBTree: the other functions fail on it.
+ * @return the tree, NULL if there is no memory or RBTREE_BTREE is or-ed with another option.
+ */
+RBTree *newRBTreeWithOptions(CompareFunc compFunc, FreeFunc freeFunc, int options)
+{
+    if ((options & RBTREE_BTREE) && options != RBTREE_BTREE)
     {
-        return;
+        return NULL;
     }
-    Node *p = findNodeParent(node);
-    node->right = temp->left;
-    temp->left = node;
-    temp->parent = node->parent;
-    node->parent = temp;
-
-    if(node->right != NULL)
+    TreeState *state = (TreeState *)malloc(sizeof(TreeState));
+    if (state == NULL)
     {
-        node->right->parent = node;
+        return NULL;
     }
-    if(p != NULL)
+    state->tree.root = NULL;
+    state->tree.compFunc = compFunc;
+    state->tree.freeFunc = freeFunc;
+    state->tree.size = 0;
+    state->options = options;
+    state->nodeSize = (options & RBTREE_ORDER_STATISTICS) ? sizeof(TreeNode) : sizeof(Node);
+    state->blocks = NULL;
+    state->blockUsed = SLAB_BLOCK_NODES;
+    state->freeNodes = NULL;
+    state->concurrent = NULL;
+    state->btreeRoot = NULL;
+    state->btreeHeight = 0;
+    state->spareNodes = NULL;
+    state->numOfSpareNodes = 0;
+    if (options & RBTREE_CONCURRENT)
     {
-        if(node == p->left)
-        {
-            p->left = temp;
-        }
-        else if(node == p->right)
+        // the readers may reach released nodes, so the nodes of a concurrent tree are never freed before it.
+        state->options |= RBTREE_SLAB_NODES;
+        void *concurrent;
+        if (posix_memalign(&concurrent, CACHE_LINE_SIZE, sizeof(ConcurrentState)) != 0)
         {
-            p->right = temp;
+            free(state);
+            return NULL;
         }
+        state->concurrent = (ConcurrentState *)memset(concurrent, 0, sizeof(ConcurrentState));
+        state->concurrent->epoch = 1;
+        pthread_mutex_init(&state->concurrent->writer, NULL);
     }
-    else
-    {
-        tree->root = temp;
-    }
-    temp->parent = p;
+    return &state->tree;
 }
 
 /**
- * a function that initiate a right rotate on a given tree, from the given node.
- * @param node the node to do the rotation from.
- * @param tree the tree to make the rotation on.
+ * constructs a new RBTree with the given CompareFunc.
+ * comp: a function two compare two variables.
  */
-void rotateRight(Node *node)
+RBTree *newRBTree(CompareFunc compFunc, FreeFunc freeFunc)
 {
-    Node *temp = node->left;
-    Node *p = findNodeParent(node);
-    if(temp == NULL)
+    return newRBTreeWithOptions(compFunc, freeFunc, 0);
+}
+
+/**
+ * a function that allocates a node for the given tree, from the blocks of the tree when it has a slab. the
+ * nodes released by deletions are reused first.
+ * @param tree the tree.
+ * @return the node, NULL if there is no memory.
+ */
+static Node *allocNode(RBTree *tree)
+{
+    TreeState *state = (TreeState *)tree;
+    if (!(state->options & RBTREE_SLAB_NODES))
     {
-        return;
+        return (Node *)malloc(state->nodeSize);
     }
-
-    node->left = temp->right;
-    temp->right = node;
-    node->parent = temp;
-    if(node->left != NULL)
+    if (state->freeNodes != NULL)
     {
-        node->left->parent = node;
+        Node *node = state->freeNodes;
+        state->freeNodes = node->parent;
+        return node;
     }
-
-    if(p != NULL)
+    if (state->blockUsed == SLAB_BLOCK_NODES)
     {
-        if(node == p->left)
-        {
-            p->left = temp;
-        }
-        else if(node == p->right)
+        size_t blockSize = sizeof(SlabBlock) + state->nodeSize * SLAB_BLOCK_NODES;
+        // a reader of a concurrent tree may see a new node before it is set, so its links start as NULL.
+        SlabBlock *block = (SlabBlock *)((state->concurrent != NULL) ? calloc(1, blockSize) : malloc(blockSize));
+        if (block == NULL)
         {
-            p->right = temp;
+            return NULL;
         }
+        block->next = state->blocks;
+        state->blocks = block;
+        state->blockUsed = 0;
     }
-    temp->parent = p;
+    return (Node *)((char *)state->blocks->nodes + state->nodeSize * (size_t)state->blockUsed++);
 }
 
 /**
- * a recursive function that finds if the given data is already in the given tree.
- * @param tree the tree to search in.
- * @param node a node to start from.
- * @param data the data to compare.
- * @return 0 if the item is not in the tree, other if it is.
+ * a function that checks if the nodes of the given tree keep the sizes of their subtrees.
+ * @param tree the tree.
+ * @return 1 if they do and 0 otherwise.
  */
-static int findDataInNode(RBTree *tree , Node *node, void *data)
+static int hasSizes(RBTree *tree)
 {
-	if(node == NULL)
-	{
-		return 0;
-	}
-	if(tree->compFunc(node->data, data) == 0)
-	{
-		return 1;
-	}
-	if(tree->compFunc(node->data, data) < 0)
-	{
-		return findDataInNode(tree, node->right, data);
-	}
-	else
-	{
-		return findDataInNode(tree, node->left, data);
-	}
+    return (((TreeState *)tree)->options & RBTREE_ORDER_STATISTICS) != 0;
 }
 
 /**
- * check whether the tree contains this item.
- * @param tree: the tree to add an item to.
- * @param data: item to check.
- * @return: 0 if the item is not in the tree, other if it is.
+ * a function that returns the size of the subtree of a node of a tree with order statistics.
+ * @param node a node or NULL.
+ * @return the number of nodes in its subtree.
  */
-int containsRBTree(RBTree *tree, void *data)
+static int subtreeSize(Node *node)
 {
-	if(tree->root == NULL)
-	{
-		return 0;
-	}
-	if(tree->compFunc(tree->root->data, data) == 0)
-	{
-		return 1;
-	}
-	return findDataInNode(tree, tree->root, data);
+    return (node == NULL) ? 0 : ((TreeNode *)node)->subtreeSize;
 }
 
 /**
- * a function that free's all the given tree's roots.
- * @param node a pointer to pointer for the tree node.
- * @param tree the tree to free the nodes in.
- * @return
+ * a function that adds to the subtree sizes of the given node and all the nodes above it.
+ * @param node a node or NULL.
+ * @param change the number to add.
  */
-void freeNodes(Node **node, RBTree *tree)
+static void addToSubtreeSizes(Node *node, int change)
 {
-    if(*node == NULL)
+    for (; node != NULL; node = node->parent)
     {
-        return;
+        ((TreeNode *)node)->subtreeSize += change;
     }
-    if ((*node)->left != NULL)
+}
+
+/**
+ * a function that fixes the subtree sizes after a rotation: the node that went up takes the size of the
+ * node that went down, which is counted again from its children.
+ * @param tree the tree.
+ * @param down the node that went down.
+ * @param up the node that went up.
+ */
+static void rotateSizes(RBTree *tree, Node *down, Node *up)
+{
+    if (hasSizes(tree))
     {
-        freeNodes(&(*node)->left, tree);
+        ((TreeNode *)up)->subtreeSize = subtreeSize(down);
+        ((TreeNode *)down)->subtreeSize = subtreeSize(down->left) + subtreeSize(down->right) + 1;
     }
-    if ((*node)->right != NULL)
+}
+
+/**
+ * a function that releases a node of the given tree, to the free nodes of the slab when the tree has one.
+ * the free nodes are linked by their parent.
+ * @param tree the tree.
+ * @param node the node.
+ */
+static void releaseNode(RBTree *tree, Node *node)
+{
+    TreeState *state = (TreeState *)tree;
+    if (!(state->options & RBTREE_SLAB_NODES))
     {
-        freeNodes(&(*node)->right, tree);
+        free(node);
+        return;
     }
-
-    tree->freeFunc((*node)->data);
-    free(*node);
-    *node = NULL;
+    node->parent = state->freeNodes;
+    state->freeNodes = node;
 }
 
 /**
- * free all memory of the data structure.
- * @param tree: the tree to free.
+ * a function that reads a link of a node of a concurrent tree, that a writer may change at the same time.
+ * @param link the link.
+ * @return the node it links to.
  */
-void freeRBTree(RBTree *tree)
+static Node *loadLink(Node **link)
 {
-	freeNodes(&tree->root, tree);
-	tree->root = NULL;
-	free(tree);
+    return __atomic_load_n(link, __ATOMIC_RELAXED);
 }
 
 /**
- * the function that is incharge of fixing the tree, according to the instructions.
- * @param newNode the newNode we wish to fix in the tree.
- * @param tree the tree that we fixes.
+ * a function that starts a read of a concurrent tree.
+ * @param concurrent the state of the tree.
+ * @param sequence holds the sequence the read checks against.
+ * @return 1 if the read may start and 0 if a writer is changing the tree.
  */
-void fixTree (Node *newNode, RBTree *tree)
+static int beginRead(ConcurrentState *concurrent, unsigned long *sequence)
 {
-    if (newNode->parent == NULL)
-    {
-        newNode->color = BLACK;
-        return;
-    }
-    else if (newNode->parent->color == BLACK)
-    {
-        return;
-    }
-    else if (findNodeUncle(newNode) != NULL && findNodeUncle(newNode)->color == RED)
-    {
-        case3(newNode, tree);
-    }
-    else if((findNodeUncle(newNode) == NULL || findNodeUncle(newNode)->color == BLACK) &&
-            findGrandParent(newNode) != NULL)
-    {
-        case4(newNode, tree);
-    }
+    *sequence = __atomic_load_n(&concurrent->sequence, __ATOMIC_ACQUIRE);
+    return (*sequence & 1u) == 0;
 }
 
 /**
- * the third case according to the exercise instructions.
- * @param newNode the newNode we wish to fix in the tree.
- * @param tree the tree that we fixes.
+ * a function that checks that no writer changed a concurrent tree since the read started, so everything the
+ * read loaded is valid.
+ * @param concurrent the state of the tree.
+ * @param sequence the sequence of the read.
+ * @return 1 if the read is valid and 0 otherwise.
  */
-void case3(Node *newNode, RBTree *tree)
+static int validRead(ConcurrentState *concurrent, unsigned long sequence)
 {
-    newNode->parent->color = BLACK;
-    findNodeUncle(newNode)->color = BLACK;
-    newNode->parent->parent->color = RED;
-    fixTree(findGrandParent(newNode), tree);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&concurrent->sequence, __ATOMIC_RELAXED) == sequence;
 }
 
 /**
- * the fourth case according to the exercise instructions.
- * @param newNode the newNode we wish to fix in the tree.
- * @param tree the tree that we fixes.
+ * a function that waits a little before a writer checks the readers of a concurrent tree again: it yields for
+ * the first BACKOFF_YIELDS waits and then sleeps, twice as long every time up to BACKOFF_MAX_NS, so the readers
+ * it waits for get the cpu. the readers don't sleep, they yield and then take the writer lock.
+ * @param waits the number of waits so far, counted by the function.
  */
-void case4(Node *newNode, RBTree *tree)
+static void backOff(int *waits)
 {
-    if(newNode == findNodeParent(newNode)->left && newNode->parent == findGrandParent(newNode)->right)
+    if (*waits < BACKOFF_YIELDS)
     {
-        rotateRight(findNodeParent(newNode));
-        newNode = newNode->right;
+        (*waits)++;
+        sched_yield();
+        return;
     }
-    else if(newNode == findNodeParent(newNode)->right && newNode->parent == findGrandParent(newNode)->left)
+    long nanoseconds = BACKOFF_MIN_NS;
+    for (int i = BACKOFF_YIELDS; i < *waits && nanoseconds < BACKOFF_MAX_NS; ++i)
     {
-        rotateLeft(findNodeParent(newNode), tree);
-        newNode = newNode ->left;
+        nanoseconds *= 2;
     }
-    Node *parent = findNodeParent(newNode);
-    Node *grandparent = findNodeParent(parent);
-    if(newNode == parent->left)
+    if (nanoseconds < BACKOFF_MAX_NS)
     {
-        rotateRight(grandparent);
+        (*waits)++;
     }
     else
     {
-        rotateLeft(grandparent, tree);
+        nanoseconds = BACKOFF_MAX_NS;
     }
-    parent->color = BLACK;
-    grandparent->color = RED;
+    struct timespec pause = {0, nanoseconds};
+    nanosleep(&pause, NULL);
 }
 
 /**
- * a function that updates the given tree, from the given node.
- * @param newNode the newNode we wish to fix in the tree.
- * @param tree the tree that we fixes.
+ * a function that takes a reader slot of a concurrent tree and announces the current epoch in it, the items
+ * removed from this epoch on aren't freed until the slot is left.
+ * @param concurrent the state of the tree.
+ * @return the slot.
  */
-void updateRoot(Node *newNode, RBTree *tree)
+static ReaderSlot *enterReader(ConcurrentState *concurrent)
 {
-    while(newNode->parent != NULL)
+    int local;
+    // the threads start looking from different slots, by their stacks.
+    size_t first = ((uintptr_t)&local >> 12u) % READER_SLOTS;
+    for (size_t i = first;; i = (i + 1) % READER_SLOTS)
     {
-        newNode = newNode->parent;
+        ReaderSlot *slot = &concurrent->readers[i];
+        unsigned long empty = 0;
+        unsigned long epoch = __atomic_load_n(&concurrent->epoch, __ATOMIC_SEQ_CST);
+        if (__atomic_compare_exchange_n(&slot->epoch, &empty, epoch, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        {
+            unsigned long now;
+            while ((now = __atomic_load_n(&concurrent->epoch, __ATOMIC_SEQ_CST)) != epoch)
+            {
+                epoch = now;
+                __atomic_store_n(&slot->epoch, epoch, __ATOMIC_SEQ_CST);
+            }
+            return slot;
+        }
+        if ((i + 1) % READER_SLOTS == first)
+        {
+            sched_yield();
+        }
     }
-    tree->root = newNode;
 }
 
-void initNode(void *data, Node *newNode)
+/**
+ * a function that leaves a reader slot of a concurrent tree.
+ * @param slot the slot.
+ */
+static void leaveReader(ReaderSlot *slot)
 {
-    newNode->left = NULL;
-    newNode->right = NULL;
-    newNode->parent = NULL;
-    newNode->color = RED;
-    newNode->data = data;
+    __atomic_store_n(&slot->epoch, 0, __ATOMIC_RELEASE);
 }
 
 /**
- * add an item to the tree
- * @param tree: the tree to add an item to.
- * @param data: item to add to the tree.
- * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ * a function that finds the oldest epoch of the active readers of a concurrent tree.
+ * @param concurrent the state of the tree.
+ * @return the epoch, the current epoch if there are no readers.
  */
-void addToTree(RBTree *tree, Node *root , Node *node)
+static unsigned long oldestReader(ConcurrentState *concurrent)
 {
-    if (root == NULL || tree->compFunc(node->data, root->data) >= 0)
+    unsigned long oldest = __atomic_load_n(&concurrent->epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < READER_SLOTS; ++i)
     {
-        if (root != NULL)
+        unsigned long epoch = __atomic_load_n(&concurrent->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest)
         {
-            if (root->right != NULL)
-            {
-                addToTree(tree, root->right, node);
-                return;
-            }
-            else
-            {
-                root->right = node;
-            }
+            oldest = epoch;
         }
     }
-    else
+    return oldest;
+}
+
+/**
+ * a function that starts a change of the given tree, for a concurrent tree it waits for the other writers
+ * and makes the sequence odd.
+ * @param tree the tree.
+ */
+static void beginWrite(RBTree *tree)
+{
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (concurrent != NULL)
+    {
+        pthread_mutex_lock(&concurrent->writer);
+        __atomic_store_n(&concurrent->sequence, concurrent->sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * a function that ends a change of the given tree that was started by beginWrite.
+ * @param tree the tree.
+ */
+static void endWrite(RBTree *tree)
+{
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (concurrent != NULL)
+    {
+        __atomic_store_n(&concurrent->sequence, concurrent->sequence + 1, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&concurrent->writer);
+    }
+}
+
+/**
+ * a function that waits until every reader of a concurrent tree that started before the call is done, so
+ * nothing removed before it is held by a reader. it must be called out of a write.
+ * @param concurrent the state of the tree.
+ */
+static void waitForReaders(ConcurrentState *concurrent)
+{
+    unsigned long epoch = __atomic_add_fetch(&concurrent->epoch, 1, __ATOMIC_SEQ_CST);
+    int waits = 0;
+    while (oldestReader(concurrent) < epoch)
+    {
+        backOff(&waits);
+    }
+}
+
+/**
+ * a function that frees a removed item of the given tree, in a write. the items of a concurrent tree are kept
+ * until the readers that may hold them are done.
+ * @param tree the tree.
+ * @param data the item.
+ * @return 1 if the item was freed or kept and 0 if there was no memory to keep it, then the caller frees it
+ * after waitForReaders.
+ */
+static int retireItem(RBTree *tree, void *data)
+{
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (concurrent == NULL)
+    {
+        tree->freeFunc(data);
+        return 1;
+    }
+    if (concurrent->numOfRetired == concurrent->retiredCapacity)
+    {
+        int capacity = (concurrent->retiredCapacity == 0) ? RECLAIM_BATCH : 2 * concurrent->retiredCapacity;
+        RetiredItem *retired = (RetiredItem *)realloc(concurrent->retired, sizeof(RetiredItem) * capacity);
+        if (retired == NULL)
+        {
+            return 0;
+        }
+        concurrent->retired = retired;
+        concurrent->retiredCapacity = capacity;
+    }
+    concurrent->retired[concurrent->numOfRetired].data = data;
+    concurrent->retired[concurrent->numOfRetired].epoch = __atomic_fetch_add(&concurrent->epoch, 1,
+                                                                             __ATOMIC_SEQ_CST);
+    concurrent->numOfRetired++;
+    if (concurrent->numOfRetired % RECLAIM_BATCH == 0)
+    {
+        // the items are retired in the order of their epochs, the ones before the oldest reader are freed.
+        unsigned long oldest = oldestReader(concurrent);
+        int numOfFreed = 0;
+        while (numOfFreed < concurrent->numOfRetired && concurrent->retired[numOfFreed].epoch < oldest)
+        {
+            tree->freeFunc(concurrent->retired[numOfFreed++].data);
+        }
+        concurrent->numOfRetired -= numOfFreed;
+        memmove(concurrent->retired, concurrent->retired + numOfFreed,
+                sizeof(RetiredItem) * concurrent->numOfRetired);
+    }
+    return 1;
+}
+
+/**
+ * a function that checks if the given tree keeps its items in a B+-tree.
+ * @param tree the tree.
+ * @return 1 if it does and 0 otherwise.
+ */
+static int isBTree(RBTree *tree)
+{
+    return (((TreeState *)tree)->options & RBTREE_BTREE) != 0;
+}
+
+/**
+ * a function that makes sure a B+-tree has a spare node for every node an insert may split (the leaf and the
+ * inner nodes above it) and one for a new root, so an insert never fails in the middle.
+ * @param state the state of the tree.
+ * @return 1 on success and 0 if there is no memory.
+ */
+static int reserveBTreeNodes(TreeState *state)
+{
+    while (state->numOfSpareNodes < state->btreeHeight + 2)
+    {
+        void *node;
+        if (posix_memalign(&node, CACHE_LINE_SIZE, BTREE_NODE_SIZE) != 0)
+        {
+            return 0;
+        }
+        ((BTreeLeaf *)node)->next = state->spareNodes;
+        state->spareNodes = (BTreeLeaf *)node;
+        state->numOfSpareNodes++;
+    }
+    return 1;
+}
+
+/**
+ * a function that takes a spare node of a B+-tree.
+ * @param state the state of the tree.
+ * @param isLeaf 1 for a leaf and 0 for an inner node.
+ * @return the node, without keys.
+ */
+static BTreeNode *takeBTreeNode(TreeState *state, int isLeaf)
+{
+    BTreeNode *node = &state->spareNodes->header;
+    state->spareNodes = state->spareNodes->next;
+    state->numOfSpareNodes--;
+    ((BTreeLeaf *)node)->next = NULL;
+    node->numOfKeys = 0;
+    node->isLeaf = isLeaf;
+    return node;
+}
+
+/**
+ * a function that finds the place of an item among the keys of a node of a B+-tree by a binary search.
+ * @param tree the tree.
+ * @param keys the keys of the node.
+ * @param numOfKeys the number of keys.
+ * @param data the item.
+ * @param found if not NULL, holds 1 if the key at the place is equal to the item and 0 otherwise.
+ * @return the number of keys that are smaller than the item.
+ */
+static int searchKeys(RBTree *tree, void **keys, int numOfKeys, void *data, int *found)
+{
+    int low = 0;
+    int high = numOfKeys;
+    int equal = 0;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        int comparison = tree->compFunc(data, keys[middle]);
+        if (comparison > 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            equal = comparison == 0;
+            high = middle;
+        }
+    }
+    if (found != NULL)
+    {
+        *found = equal && low < numOfKeys;
+    }
+    return low;
+}
+
+/**
+ * a function that finds the child of an inner node of a B+-tree that the given item is under.
+ * @param tree the tree.
+ * @param inner the node.
+ * @param data the item.
+ * @return the index of the child.
+ */
+static int findChild(RBTree *tree, BTreeInner *inner, void *data)
+{
+    int found;
+    int index = searchKeys(tree, inner->keys, inner->header.numOfKeys, data, &found);
+    return found ? index + 1 : index;
+}
+
+/**
+ * a function that adds an item to a leaf of a B+-tree, the leaf is split in two when it is full. a full last
+ * leaf that the item goes to the end of keeps all its keys, so sorted input fills the leaves.
+ * @param state the state of the tree.
+ * @param leaf the leaf.
+ * @param index the place of the item.
+ * @param data the item.
+ * @return the new leaf to the right of the leaf, NULL if it wasn't split.
+ */
+static BTreeLeaf *addToLeaf(TreeState *state, BTreeLeaf *leaf, int index, void *data)
+{
+    BTreeLeaf *right = NULL;
+    BTreeLeaf *target = leaf;
+    int numOfKeys = leaf->header.numOfKeys;
+    if (numOfKeys == BTREE_LEAF_KEYS)
+    {
+        int kept = (index == numOfKeys && leaf->next == NULL) ? numOfKeys : numOfKeys / 2;
+        right = (BTreeLeaf *)takeBTreeNode(state, 1);
+        memcpy(right->keys, leaf->keys + kept, sizeof(void *) * (numOfKeys - kept));
+        right->header.numOfKeys = numOfKeys - kept;
+        right->next = leaf->next;
+        leaf->next = right;
+        leaf->header.numOfKeys = kept;
+        if (index >= kept)
+        {
+            target = right;
+            index -= kept;
+        }
+    }
+    memmove(target->keys + index + 1, target->keys + index, sizeof(void *) * (target->header.numOfKeys - index));
+    target->keys[index] = data;
+    target->header.numOfKeys++;
+    return right;
+}
+
+/**
+ * a function that adds a child to an inner node of a B+-tree after the given index, the node is split in two
+ * when it is full, and its middle key goes up.
+ * @param state the state of the tree.
+ * @param inner the node.
+ * @param index the index of the child that was split.
+ * @param key the first item under the new child.
+ * @param child the new child.
+ * @param upKey holds the key that goes up when the node is split.
+ * @return the new node to the right of the node, NULL if it wasn't split.
+ */
+static BTreeInner *addToInner(TreeState *state, BTreeInner *inner, int index, void *key, BTreeNode *child,
+                              void **upKey)
+{
+    void *keys[BTREE_INNER_KEYS + 1];
+    BTreeNode *children[BTREE_INNER_KEYS + 2];
+    int numOfKeys = inner->header.numOfKeys;
+    if (numOfKeys < BTREE_INNER_KEYS)
+    {
+        memmove(inner->keys + index + 1, inner->keys + index, sizeof(void *) * (numOfKeys - index));
+        memmove(inner->children + index + 2, inner->children + index + 1,
+                sizeof(BTreeNode *) * (numOfKeys - index));
+        inner->keys[index] = key;
+        inner->children[index + 1] = child;
+        inner->header.numOfKeys++;
+        return NULL;
+    }
+    memcpy(keys, inner->keys, sizeof(void *) * index);
+    keys[index] = key;
+    memcpy(keys + index + 1, inner->keys + index, sizeof(void *) * (numOfKeys - index));
+    memcpy(children, inner->children, sizeof(BTreeNode *) * (index + 1));
+    children[index + 1] = child;
+    memcpy(children + index + 2, inner->children + index + 1, sizeof(BTreeNode *) * (numOfKeys - index));
+    int middle = (numOfKeys + 1) / 2;
+    BTreeInner *right = (BTreeInner *)takeBTreeNode(state, 0);
+    memcpy(inner->keys, keys, sizeof(void *) * middle);
+    memcpy(inner->children, children, sizeof(BTreeNode *) * (middle + 1));
+    inner->header.numOfKeys = middle;
+    *upKey = keys[middle];
+    right->header.numOfKeys = numOfKeys - middle;
+    memcpy(right->keys, keys + middle + 1, sizeof(void *) * right->header.numOfKeys);
+    memcpy(right->children, children + middle + 1, sizeof(BTreeNode *) * (right->header.numOfKeys + 1));
+    return right;
+}
+
+/**
+ * a function that adds an item to a B+-tree, in a single descent that remembers the path and splits the full
+ * nodes on the way back up.
+ * @param tree the tree.
+ * @param data the item.
+ * @return 1 if the item was added, 0 if it is already in the tree or there is no memory.
+ */
+static int addToBTree(RBTree *tree, void *data)
+{
+    TreeState *state = (TreeState *)tree;
+    BTreeInner *path[sizeof(int) * 8];
+    int indices[sizeof(int) * 8];
+    if (data == NULL || !reserveBTreeNodes(state))
+    {
+        return 0;
+    }
+    if (state->btreeRoot == NULL)
+    {
+        state->btreeRoot = takeBTreeNode(state, 1);
+    }
+    BTreeNode *node = state->btreeRoot;
+    for (int level = 0; !node->isLeaf; ++level)
+    {
+        path[level] = (BTreeInner *)node;
+        indices[level] = findChild(tree, path[level], data);
+        node = path[level]->children[indices[level]];
+    }
+    int found;
+    BTreeLeaf *leaf = (BTreeLeaf *)node;
+    int index = searchKeys(tree, leaf->keys, leaf->header.numOfKeys, data, &found);
+    if (found)
+    {
+        return 0;
+    }
+    BTreeNode *split = (BTreeNode *)addToLeaf(state, leaf, index, data);
+    void *key = (split == NULL) ? NULL : ((BTreeLeaf *)split)->keys[0];
+    for (int level = state->btreeHeight - 1; level >= 0 && split != NULL; --level)
+    {
+        split = (BTreeNode *)addToInner(state, path[level], indices[level], key, split, &key);
+    }
+    if (split != NULL)
+    {
+        BTreeInner *root = (BTreeInner *)takeBTreeNode(state, 0);
+        root->header.numOfKeys = 1;
+        root->keys[0] = key;
+        root->children[0] = state->btreeRoot;
+        root->children[1] = split;
+        state->btreeRoot = &root->header;
+        state->btreeHeight++;
+    }
+    tree->size++;
+    return 1;
+}
+
+/**
+ * a function that checks if a B+-tree contains the given item.
+ * @param tree the tree.
+ * @param data the item.
+ * @return 1 if it does and 0 otherwise.
+ */
+static int containsBTree(RBTree *tree, void *data)
+{
+    BTreeNode *node = ((TreeState *)tree)->btreeRoot;
+    if (node == NULL)
+    {
+        return 0;
+    }
+    while (!node->isLeaf)
+    {
+        node = ((BTreeInner *)node)->children[findChild(tree, (BTreeInner *)node, data)];
+    }
+    int found;
+    searchKeys(tree, ((BTreeLeaf *)node)->keys, node->numOfKeys, data, &found);
+    return found;
+}
+
+/**
+ * a function that activates a function on each item of a B+-tree in an ascending order, along the leaves.
+ * @param tree the tree.
+ * @param func the function.
+ * @param args more optional arguments to the function.
+ * @return 0 if there were no items, other otherwise.
+ */
+static int forEachBTree(RBTree *tree, forEachFunc func, void *args)
+{
+    BTreeNode *node = ((TreeState *)tree)->btreeRoot;
+    if (tree->size == 0)
+    {
+        return 0;
+    }
+    while (!node->isLeaf)
+    {
+        node = ((BTreeInner *)node)->children[0];
+    }
+    for (BTreeLeaf *leaf = (BTreeLeaf *)node; leaf != NULL; leaf = leaf->next)
+    {
+        for (int i = 0; i < leaf->header.numOfKeys; ++i)
+        {
+            func(leaf->keys[i], args);
+        }
+    }
+    return 1;
+}
+
+/**
+ * a function that frees the nodes of a B+-tree under the given node, and their items.
+ * @param tree the tree.
+ * @param node the node.
+ */
+static void freeBTreeNodes(RBTree *tree, BTreeNode *node)
+{
+    if (node->isLeaf)
+    {
+        for (int i = 0; i < node->numOfKeys; ++i)
+        {
+            tree->freeFunc(((BTreeLeaf *)node)->keys[i]);
+        }
+    }
+    else
+    {
+        for (int i = 0; i <= node->numOfKeys; ++i)
+        {
+            freeBTreeNodes(tree, ((BTreeInner *)node)->children[i]);
+        }
+    }
+    free(node);
+}
+
+/**
+ * a function that returns the given node parent.
+ * @param node: the node.
+ * @return the node's parent
+ */
+Node* findNodeParent(Node *node)
+{
+    if (node->parent == NULL)
+    {
+        return NULL;
+    }
+    else
+    {
+        return node->parent;
+    }
+}
+
+/**
+ * a function that returns the given node's grandParent.
+ * @param node: the node.
+ * @return the node's grandpa
+ */
+Node* findGrandParent(Node *node)
+{
+    return findNodeParent(node->parent);
+}
+
+/**
+ * a function that returns the given node's uncle.
+ * @param node: the node.
+ * @return the node's uncle
+ */
+Node* findNodeUncle(Node *node)
+{
+    int isRightNode = 0;
+    if (findNodeParent(node) != NULL && findGrandParent(node) != NULL)
+    {
+        if (node->parent == findGrandParent(node)->left)
+        {
+            isRightNode = 1;
+        }
+        else
+        {
+            isRightNode = 0;
+        }
+    }
+    else
+    {
+        return NULL;
+    }
+    if(isRightNode)
+    {
+        return findGrandParent(node)->right;
+    }
+    return findGrandParent(node)->left;
+}
+
+/**
+ * a function that initiate a left rotate on a given tree, from the given node.
+ * @param node the node to do the rotation from.
+ * @param tree the tree to make the rotation on.
+ */
+void rotateLeft(Node *node, RBTree* tree)
+{
+    Node *temp = node->right;
+    if(temp == NULL)
+    {
+        return;
+    }
+    Node *p = findNodeParent(node);
+    node->right = temp->left;
+    temp->left = node;
+    temp->parent = node->parent;
+    node->parent = temp;
+
+    if(node->right != NULL)
+    {
+        node->right->parent = node;
+    }
+    if(p != NULL)
+    {
+        if(node == p->left)
+        {
+            p->left = temp;
+        }
+        else if(node == p->right)
+        {
+            p->right = temp;
+        }
+    }
+    else
+    {
+        tree->root = temp;
+    }
+    temp->parent = p;
+    rotateSizes(tree, node, temp);
+}
+
+/**
+ * a function that initiate a right rotate on a given tree, from the given node.
+ * @param node the node to do the rotation from.
+ * @param tree the tree to make the rotation on.
+ */
+void rotateRight(Node *node, RBTree *tree)
+{
+    Node *temp = node->left;
+    Node *p = findNodeParent(node);
+    if(temp == NULL)
+    {
+        return;
+    }
+
+    node->left = temp->right;
+    temp->right = node;
+    node->parent = temp;
+    if(node->left != NULL)
+    {
+        node->left->parent = node;
+    }
+
+    if(p != NULL)
+    {
+        if(node == p->left)
+        {
+            p->left = temp;
+        }
+        else if(node == p->right)
+        {
+            p->right = temp;
+        }
+    }
+    else
+    {
+        tree->root = temp;
+    }
+    temp->parent = p;
+    rotateSizes(tree, node, temp);
+}
+
+/**
+ * an iterative search for the given data, with one comparison on every level of the tree.
+ * @param tree the tree to search in.
+ * @param data the data to compare.
+ * @param parent if not NULL, holds the last node compared, where the data would be added.
+ * @param lastComparison if not NULL, holds the result of the last comparison.
+ * @return the node of the data, NULL if the item is not in the tree.
+ */
+static Node *findNode(RBTree *tree, void *data, Node **parent, int *lastComparison)
+{
+    Node *curr = tree->root;
+    Node *last = NULL;
+    int comparison = 0;
+    while (curr != NULL)
+    {
+        comparison = tree->compFunc(data, curr->data);
+        if (comparison == 0)
+        {
+            break;
+        }
+        last = curr;
+        curr = (comparison < 0) ? curr->left : curr->right;
+    }
+    if (parent != NULL)
+    {
+        *parent = last;
+    }
+    if (lastComparison != NULL)
+    {
+        *lastComparison = comparison;
+    }
+    return curr;
+}
+
+/**
+ * a function that looks for an item in a concurrent tree without a lock, a single attempt that fails if a
+ * writer changed the tree on the way. the reader must be in a reader slot.
+ * @param tree the tree.
+ * @param concurrent the state of the tree.
+ * @param data the item.
+ * @return 1 if the item is in the tree, 0 if it is not, -1 if the attempt failed.
+ */
+static int findConcurrent(RBTree *tree, ConcurrentState *concurrent, void *data)
+{
+    unsigned long sequence;
+    if (!beginRead(concurrent, &sequence))
+    {
+        return -1;
+    }
+    Node *curr = loadLink(&tree->root);
+    while (curr != NULL)
+    {
+        void *item = __atomic_load_n(&curr->data, __ATOMIC_RELAXED);
+        // the item is compared only when it was surely in the tree.
+        if (!validRead(concurrent, sequence))
+        {
+            return -1;
+        }
+        int comparison = tree->compFunc(data, item);
+        if (comparison == 0)
+        {
+            return 1;
+        }
+        curr = loadLink((comparison < 0) ? &curr->left : &curr->right);
+    }
+    return validRead(concurrent, sequence) ? 0 : -1;
+}
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree to add an item to.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsRBTree(RBTree *tree, void *data)
+{
+    if (isBTree(tree))
+    {
+        return containsBTree(tree, data);
+    }
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (concurrent == NULL)
+    {
+        return findNode(tree, data, NULL, NULL) != NULL;
+    }
+    ReaderSlot *slot = enterReader(concurrent);
+    int found = findConcurrent(tree, concurrent, data);
+    for (int attempt = 1; attempt < READ_RETRIES && found < 0; ++attempt)
+    {
+        sched_yield();
+        found = findConcurrent(tree, concurrent, data);
+    }
+    if (found < 0)
+    {
+        // the writers kept changing the tree, so this reader waits for them.
+        pthread_mutex_lock(&concurrent->writer);
+        found = findNode(tree, data, NULL, NULL) != NULL;
+        pthread_mutex_unlock(&concurrent->writer);
+    }
+    leaveReader(slot);
+    return found;
+}
+
+/**
+ * a function that free's all the given tree's roots.
+ * @param node a pointer to pointer for the tree node.
+ * @param tree the tree to free the nodes in.
+ * @return
+ */
+void freeNodes(Node **node, RBTree *tree)
+{
+    if(*node == NULL)
+    {
+        return;
+    }
+    if ((*node)->left != NULL)
+    {
+        freeNodes(&(*node)->left, tree);
+    }
+    if ((*node)->right != NULL)
+    {
+        freeNodes(&(*node)->right, tree);
+    }
+
+    tree->freeFunc((*node)->data);
+    free(*node);
+    *node = NULL;
+}
+
+/**
+ * free all memory of the data structure.
+ * @param tree: the tree to free.
+ */
+void freeRBTree(RBTree *tree)
+{
+    TreeState *state = (TreeState *)tree;
+    if (state->options & RBTREE_SLAB_NODES)
+    {
+        // the elements are freed in order, then the nodes go away with their blocks.
+        for (Node *curr = (tree->root == NULL) ? NULL : findLeaf(tree->root); curr != NULL;
+             curr = returnNodesInOrder(curr))
+        {
+            tree->freeFunc(curr->data);
+        }
+        while (state->blocks != NULL)
+        {
+            SlabBlock *next = state->blocks->next;
+            free(state->blocks);
+            state->blocks = next;
+        }
+    }
+    else
+    {
+        freeNodes(&tree->root, tree);
+    }
+    if (state->btreeRoot != NULL)
+    {
+        freeBTreeNodes(tree, state->btreeRoot);
+    }
+    while (state->spareNodes != NULL)
+    {
+        BTreeLeaf *next = state->spareNodes->next;
+        free(state->spareNodes);
+        state->spareNodes = next;
+    }
+    if (state->concurrent != NULL)
+    {
+        for (int i = 0; i < state->concurrent->numOfRetired; ++i)
+        {
+            tree->freeFunc(state->concurrent->retired[i].data);
+        }
+        free(state->concurrent->retired);
+        pthread_mutex_destroy(&state->concurrent->writer);
+        free(state->concurrent);
+    }
+	tree->root = NULL;
+	free(state);
+}
+
+/**
+ * the function that is incharge of fixing the tree, according to the instructions.
+ * @param newNode the newNode we wish to fix in the tree.
+ * @param tree the tree that we fixes.
+ */
+void fixTree (Node *newNode, RBTree *tree)
+{
+    if (newNode->parent == NULL)
+    {
+        newNode->color = BLACK;
+        return;
+    }
+    else if (newNode->parent->color == BLACK)
+    {
+        return;
+    }
+    else if (findNodeUncle(newNode) != NULL && findNodeUncle(newNode)->color == RED)
+    {
+        case3(newNode, tree);
+    }
+    else if((findNodeUncle(newNode) == NULL || findNodeUncle(newNode)->color == BLACK) &&
+            findGrandParent(newNode) != NULL)
+    {
+        case4(newNode, tree);
+    }
+}
+
+/**
+ * the third case according to the exercise instructions.
+ * @param newNode the newNode we wish to fix in the tree.
+ * @param tree the tree that we fixes.
+ */
+void case3(Node *newNode, RBTree *tree)
+{
+    newNode->parent->color = BLACK;
+    findNodeUncle(newNode)->color = BLACK;
+    newNode->parent->parent->color = RED;
+    fixTree(findGrandParent(newNode), tree);
+}
+
+/**
+ * the fourth case according to the exercise instructions.
+ * @param newNode the newNode we wish to fix in the tree.
+ * @param tree the tree that we fixes.
+ */
+void case4(Node *newNode, RBTree *tree)
+{
+    if(newNode == findNodeParent(newNode)->left && newNode->parent == findGrandParent(newNode)->right)
+    {
+        rotateRight(findNodeParent(newNode), tree);
+        newNode = newNode->right;
+    }
+    else if(newNode == findNodeParent(newNode)->right && newNode->parent == findGrandParent(newNode)->left)
+    {
+        rotateLeft(findNodeParent(newNode), tree);
+        newNode = newNode ->left;
+    }
+    Node *parent = findNodeParent(newNode);
+    Node *grandparent = findNodeParent(parent);
+    if(newNode == parent->left)
+    {
+        rotateRight(grandparent, tree);
+    }
+    else
+    {
+        rotateLeft(grandparent, tree);
+    }
+    parent->color = BLACK;
+    grandparent->color = RED;
+}
+
+/**
+ * a function that updates the given tree, from the given node.
+ * @param newNode the newNode we wish to fix in the tree.
+ * @param tree the tree that we fixes.
+ */
+void updateRoot(Node *newNode, RBTree *tree)
+{
+    while(newNode->parent != NULL)
+    {
+        newNode = newNode->parent;
+    }
+    tree->root = newNode;
+}
+
+void initNode(void *data, Node *newNode)
+{
+    newNode->left = NULL;
+    newNode->right = NULL;
+    newNode->parent = NULL;
+    newNode->color = RED;
+    newNode->data = data;
+}
+
+/**
+ * a function that finds the node before the given node in the order.
+ * @param node a node.
+ * @return the previous node in the order, NULL for the first node.
+ */
+static Node *previousNode(Node *node)
+{
+    if (node->left != NULL)
+    {
+        node = node->left;
+        while (node->right != NULL)
+        {
+            node = node->right;
+        }
+        return node;
+    }
+    Node *p = node->parent;
+    while (p != NULL && node == p->left)
+    {
+        node = p;
+        p = p->parent;
+    }
+    return p;
+}
+
+/**
+ * a function that finds where the data goes next to the hint node, so an insert next to the previous one (as
+ * in sorted input) costs one or two comparisons instead of a descent from the root.
+ * @param tree the tree.
+ * @param data the data to add.
+ * @param hint a node of the tree.
+ * @param parent holds the node to add the data under, or the node of the data if it is in the tree.
+ * @param lastComparison holds the side of the parent to add the data on, 0 if the data is in the tree.
+ * @return 1 if the place was found and 0 if the data is not next to the hint.
+ */
+static int findPlaceByHint(RBTree *tree, void *data, Node *hint, Node **parent, int *lastComparison)
+{
+    int comparison = tree->compFunc(data, hint->data);
+    if (comparison == 0)
+    {
+        *parent = hint;
+        *lastComparison = 0;
+        return 1;
+    }
+    Node *neighbour = (comparison > 0) ? returnNodesInOrder(hint) : previousNode(hint);
+    if (neighbour != NULL)
+    {
+        int neighbourComparison = tree->compFunc(data, neighbour->data);
+        if (neighbourComparison == 0)
+        {
+            *parent = neighbour;
+            *lastComparison = 0;
+            return 1;
+        }
+        if ((neighbourComparison > 0) == (comparison > 0))
+        {
+            return 0;
+        }
+    }
+    // the data is between the hint and its neighbour, one of them has a free child on that side.
+    if ((comparison > 0 && hint->right == NULL) || (comparison < 0 && hint->left == NULL))
+    {
+        *parent = hint;
+        *lastComparison = comparison;
+    }
+    else
+    {
+        *parent = neighbour;
+        *lastComparison = -comparison;
+    }
+    return 1;
+}
+
+/**
+ * a function that adds an item to the tree or finds the item that is equal to it, as insertOrFindRBTree does,
+ * in a write.
+ * @param tree the tree.
+ * @param data the item.
+ * @param hint NULL or a node next to the place of the item, holds the node of the item.
+ * @param added NULL or holds 1 if the item was added and 0 otherwise.
+ * @return data if it was added, the item that is equal to it if there is one, NULL on failure.
+ */
+static void *insertOrFind(RBTree *tree, void *data, Node **hint, int *added)
+{
+    if (added != NULL)
+    {
+        *added = 0;
+    }
+    if (data == NULL || tree == NULL)
+    {
+        return NULL;
+    }
+    Node *parent;
+    int comparison;
+    if (hint == NULL || *hint == NULL || !findPlaceByHint(tree, data, *hint, &parent, &comparison))
+    {
+        Node *found = findNode(tree, data, &parent, &comparison);
+        if (found != NULL)
+        {
+            parent = found;
+            comparison = 0;
+        }
+    }
+    if (parent != NULL && comparison == 0)
+    {
+        if (hint != NULL)
+        {
+            *hint = parent;
+        }
+        return parent->data;
+    }
+    Node *newNode = allocNode(tree);
+    if (newNode == NULL)
+    {
+        return NULL;
+    }
+    initNode(data, newNode);
+    newNode->parent = parent;
+    if (parent == NULL)
+    {
+        tree->root = newNode;
+    }
+    else if (comparison < 0)
+    {
+        parent->left = newNode;
+    }
+    else
+    {
+        parent->right = newNode;
+    }
+    if (hasSizes(tree))
+    {
+        ((TreeNode *)newNode)->subtreeSize = 0;
+        addToSubtreeSizes(newNode, 1);
+    }
+    fixTree(newNode, tree);
+    updateRoot(newNode, tree);
+    tree->size++;
+    if (added != NULL)
+    {
+        *added = 1;
+    }
+    if (hint != NULL)
+    {
+        *hint = newNode;
+    }
+    return data;
+}
+
+/**
+ * add an item to the tree, or find the item of the tree that is equal to it, in a single descent with one
+ * comparison on every level.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @param hint: if not NULL, a node of the tree that is next to the place of the item (NULL in it for none),
+ * as the node of the previous insert is for sorted input. holds the node of the item.
+ * @return: data if it was added, the item of the tree that is equal to it if there is one, NULL on failure
+ * (and always for a B+-tree).
+ */
+void *insertOrFindRBTree(RBTree *tree, void *data, Node **hint)
+{
+    if (tree == NULL || isBTree(tree))
+    {
+        return NULL;
+    }
+    beginWrite(tree);
+    void *result = insertOrFind(tree, data, hint, NULL);
+    endWrite(tree);
+    return result;
+}
+
+/**
+ * add an item to the tree
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ */
+int addToRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL)
+    {
+        return 0;
+    }
+    if (isBTree(tree))
+    {
+        return addToBTree(tree, data);
+    }
+    beginWrite(tree);
+    int added;
+    insertOrFind(tree, data, NULL, &added);
+    endWrite(tree);
+    return added;
+}
+
+/**
+ * a function that checks the color of a node, the missing children of a node are black.
+ * @param node a node or NULL.
+ * @return 1 if the node is black and 0 if it is red.
+ */
+static int isBlack(Node *node)
+{
+    return node == NULL || node->color == BLACK;
+}
+
+/**
+ * a function that puts a node (or NULL) in the place of a child of the given parent.
+ * @param tree the tree.
+ * @param parent the parent, NULL if the old node is the root.
+ * @param oldNode the child to replace.
+ * @param newNode the node to put in its place.
+ */
+static void replaceChild(RBTree *tree, Node *parent, Node *oldNode, Node *newNode)
+{
+    if (parent == NULL)
+    {
+        tree->root = newNode;
+    }
+    else if (parent->left == oldNode)
+    {
+        parent->left = newNode;
+    }
+    else
+    {
+        parent->right = newNode;
+    }
+    if (newNode != NULL)
+    {
+        newNode->parent = parent;
+    }
+}
+
+/**
+ * the function that fixes the tree after a black node was removed, the given node is one black short on
+ * every path through it. the missing black moves up until it reaches a red node or the root, or the
+ * rotations of the sibling give it back.
+ * @param node the node in the place of the removed one, may be NULL.
+ * @param parent the parent of the node.
+ * @param tree the tree that we fixes.
+ */
+static void fixDelete(Node *node, Node *parent, RBTree *tree)
+{
+    while (node != tree->root && isBlack(node))
+    {
+        int isLeft = node == parent->left;
+        Node *sibling = isLeft ? parent->right : parent->left;
+        if (sibling->color == RED)
+        {
+            sibling->color = BLACK;
+            parent->color = RED;
+            if (isLeft)
+            {
+                rotateLeft(parent, tree);
+            }
+            else
+            {
+                rotateRight(parent, tree);
+            }
+            sibling = isLeft ? parent->right : parent->left;
+        }
+        if (isBlack(sibling->left) && isBlack(sibling->right))
+        {
+            sibling->color = RED;
+            node = parent;
+            parent = node->parent;
+            continue;
+        }
+        if (isLeft && isBlack(sibling->right))
+        {
+            sibling->left->color = BLACK;
+            sibling->color = RED;
+            rotateRight(sibling, tree);
+            sibling = parent->right;
+        }
+        else if (!isLeft && isBlack(sibling->left))
+        {
+            sibling->right->color = BLACK;
+            sibling->color = RED;
+            rotateLeft(sibling, tree);
+            sibling = parent->left;
+        }
+        sibling->color = parent->color;
+        parent->color = BLACK;
+        if (isLeft)
+        {
+            sibling->right->color = BLACK;
+            rotateLeft(parent, tree);
+        }
+        else
+        {
+            sibling->left->color = BLACK;
+            rotateRight(parent, tree);
+        }
+        node = tree->root;
+    }
+    if (node != NULL)
+    {
+        node->color = BLACK;
+    }
+}
+
+/**
+ * a function that removes an item from the tree without freeing it, in a write.
+ * @param tree the tree.
+ * @param data an item equal to the item to remove.
+ * @return the removed item, NULL if it is not in the tree.
+ */
+static void *removeItem(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    Node *node = findNode(tree, data, NULL, NULL);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    Node *child;
+    Node *parent;
+    Color removedColor = node->color;
+    if (node->left == NULL || node->right == NULL)
+    {
+        child = (node->left != NULL) ? node->left : node->right;
+        parent = node->parent;
+        replaceChild(tree, node->parent, node, child);
+    }
+    else
     {
-        if (root->left != NULL)
+        // the next node takes the place of the node, and its own place is the one that is removed.
+        Node *next = findLeaf(node->right);
+        removedColor = next->color;
+        child = next->right;
+        parent = next;
+        if (next->parent != node)
         {
-            addToTree(tree, root->left, node);
-            return;
+            parent = next->parent;
+            replaceChild(tree, next->parent, next, next->right);
+            next->right = node->right;
+            next->right->parent = next;
         }
-        else
+        replaceChild(tree, node->parent, node, next);
+        next->left = node->left;
+        next->left->parent = next;
+        next->color = node->color;
+        if (hasSizes(tree))
         {
-            root->left = node;
+            ((TreeNode *)next)->subtreeSize = subtreeSize(node);
         }
     }
-    node->parent = root;
+    if (hasSizes(tree))
+    {
+        // the sizes are fixed up from the place that was removed, before the rotations of the fix.
+        addToSubtreeSizes(parent, -1);
+    }
+    if (removedColor == BLACK)
+    {
+        fixDelete(child, parent, tree);
+    }
+    void *removed = node->data;
+    releaseNode(tree, node);
+    tree->size--;
+    return removed;
 }
+
 /**
- * add an item to the tree
- * @param tree: the tree to add an item to.
- * @param data: item to add to the tree.
- * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ * remove an item from the tree without freeing it. in a concurrent tree it returns when no reader holds the
+ * item anymore.
+ * @param tree: the tree to remove the item from.
+ * @param data: an item equal to the item to remove.
+ * @return: the removed item, NULL if it is not in the tree or the tree is a B+-tree.
  */
-int addToRBTree(RBTree *tree, void *data)
+void *removeFromRBTree(RBTree *tree, void *data)
 {
-    if (data != NULL && tree != NULL)
+    if (tree == NULL || isBTree(tree))
     {
-        if (containsRBTree(tree, data))
-        {
-            return 0;
-        }
-        Node *newNode = (Node *) malloc(sizeof(Node));
-        if (newNode == NULL)
-        {
-            return 0;
-        }
-        initNode(data, newNode);
-        addToTree(tree, tree->root, newNode);
-        fixTree(newNode, tree);
-        updateRoot(newNode, tree);
-        tree->size++;
-        return 1;
+        return NULL;
+    }
+    beginWrite(tree);
+    void *removed = removeItem(tree, data);
+    endWrite(tree);
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (removed != NULL && concurrent != NULL)
+    {
+        waitForReaders(concurrent);
+    }
+    return removed;
+}
+
+/**
+ * delete an item from the tree, the item is freed with the freeFunc of the tree.
+ * @param tree: the tree to delete the item from.
+ * @param data: an item equal to the item to delete.
+ * @return: 0 if the item is not in the tree or the tree is a B+-tree, other on success.
+ */
+int deleteFromRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || isBTree(tree))
+    {
+        return 0;
+    }
+    beginWrite(tree);
+    void *removed = removeItem(tree, data);
+    int retired = removed == NULL || retireItem(tree, removed);
+    endWrite(tree);
+    if (!retired)
+    {
+        waitForReaders(((TreeState *)tree)->concurrent);
+        tree->freeFunc(removed);
     }
-    return 0;
+    return removed != NULL;
 }
 
 /**
@@ -432,6 +1693,121 @@ Node *returnNodesInOrder(Node *node)
 }
 
 
+/**
+ * a function that collects the next items of a concurrent tree without a lock, a single attempt that fails if a
+ * writer changed the tree on the way. the reader must be in a reader slot.
+ * @param tree the tree.
+ * @param concurrent the state of the tree.
+ * @param last the last item that was collected, NULL to start from the first item.
+ * @param chunk holds the items, READ_CHUNK_LEN at most.
+ * @param numOfItems holds the number of items.
+ * @return 1 if the items were collected and 0 if the attempt failed.
+ */
+static int collectConcurrent(RBTree *tree, ConcurrentState *concurrent, void *last, void **chunk, int *numOfItems)
+{
+    unsigned long sequence;
+    if (!beginRead(concurrent, &sequence))
+    {
+        return 0;
+    }
+    Node *curr = loadLink(&tree->root);
+    Node *next = NULL;
+    while (curr != NULL)
+    {
+        void *item = __atomic_load_n(&curr->data, __ATOMIC_RELAXED);
+        if (!validRead(concurrent, sequence))
+        {
+            return 0;
+        }
+        if (last == NULL || tree->compFunc(last, item) < 0)
+        {
+            next = curr;
+            curr = loadLink(&curr->left);
+        }
+        else
+        {
+            curr = loadLink(&curr->right);
+        }
+    }
+    *numOfItems = 0;
+    // the walk in order of returnNodesInOrder, every step is checked so a changing tree can't trap it.
+    while (next != NULL && *numOfItems < READ_CHUNK_LEN)
+    {
+        chunk[(*numOfItems)++] = __atomic_load_n(&next->data, __ATOMIC_RELAXED);
+        Node *child = loadLink(&next->right);
+        if (child != NULL)
+        {
+            next = child;
+            while ((child = loadLink(&next->left)) != NULL && validRead(concurrent, sequence))
+            {
+                next = child;
+            }
+        }
+        else
+        {
+            Node *p = loadLink(&next->parent);
+            while (p != NULL && next == loadLink(&p->right) && validRead(concurrent, sequence))
+            {
+                next = p;
+                p = loadLink(&p->parent);
+            }
+            next = p;
+        }
+        if (!validRead(concurrent, sequence))
+        {
+            return 0;
+        }
+    }
+    return validRead(concurrent, sequence);
+}
+
+/**
+ * a function that activates a function on each item of a concurrent tree, in an ascending order. the items are
+ * collected in chunks without a lock and the function runs out of the reads, so the writers may change the
+ * tree between the chunks: every item is seen at most once, and the items that are in the tree all along are
+ * seen.
+ * @param tree the tree.
+ * @param concurrent the state of the tree.
+ * @param func the function to activate on all items.
+ * @param args more optional arguments to the function.
+ * @return 0 if there were no items, other otherwise.
+ */
+static int forEachConcurrent(RBTree *tree, ConcurrentState *concurrent, forEachFunc func, void *args)
+{
+    void *chunk[READ_CHUNK_LEN];
+    void *last = NULL;
+    int numOfItems = 0;
+    int total = 0;
+    // the reader slot keeps the collected items from being freed until the function is done with them.
+    ReaderSlot *slot = enterReader(concurrent);
+    do
+    {
+        int collected = collectConcurrent(tree, concurrent, last, chunk, &numOfItems);
+        for (int attempt = 1; attempt < READ_RETRIES && !collected; ++attempt)
+        {
+            sched_yield();
+            collected = collectConcurrent(tree, concurrent, last, chunk, &numOfItems);
+        }
+        if (!collected)
+        {
+            pthread_mutex_lock(&concurrent->writer);
+            collectConcurrent(tree, concurrent, last, chunk, &numOfItems);
+            pthread_mutex_unlock(&concurrent->writer);
+        }
+        for (int i = 0; i < numOfItems; ++i)
+        {
+            func(chunk[i], args);
+        }
+        if (numOfItems > 0)
+        {
+            last = chunk[numOfItems - 1];
+            total += numOfItems;
+        }
+    } while (numOfItems == READ_CHUNK_LEN);
+    leaveReader(slot);
+    return total > 0;
+}
+
 /**
  * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
  * function returns 0, the process stops.
@@ -442,6 +1818,15 @@ Node *returnNodesInOrder(Node *node)
  */
 int forEachRBTree(RBTree *tree, forEachFunc func, void *args)
 {
+    if (isBTree(tree))
+    {
+        return forEachBTree(tree, func, args);
+    }
+    ConcurrentState *concurrent = ((TreeState *)tree)->concurrent;
+    if (concurrent != NULL)
+    {
+        return forEachConcurrent(tree, concurrent, func, args);
+    }
     if(tree->size == 0)
     {
         return 0;
@@ -454,3 +1839,394 @@ int forEachRBTree(RBTree *tree, forEachFunc func, void *args)
 	}
 	return 1;
 }
+
+/**
+ * a part of an array of items that is sorted by one thread of the parallel sort.
+ */
+typedef struct SortTask
+{
+    void **data;
+    void **buffer;
+    int n;
+    int depth;
+    CompareFunc compFunc;
+} SortTask;
+
+/**
+ * a stable merge sort of the given items.
+ * @param data the items.
+ * @param buffer space for n items.
+ * @param n the number of items.
+ * @param compFunc the function to compare the items.
+ */
+static void mergeSort(void **data, void **buffer, int n, CompareFunc compFunc)
+{
+    if (n <= INSERTION_SORT_LEN)
+    {
+        for (int i = 1; i < n; ++i)
+        {
+            void *item = data[i];
+            int j = i;
+            for (; j > 0 && compFunc(data[j - 1], item) > 0; --j)
+            {
+                data[j] = data[j - 1];
+            }
+            data[j] = item;
+        }
+        return;
+    }
+    int half = n / 2;
+    mergeSort(data, buffer, half, compFunc);
+    mergeSort(data + half, buffer + half, n - half, compFunc);
+    int left = 0;
+    int right = half;
+    for (int i = 0; i < n; ++i)
+    {
+        // on equal items the left one goes first, which keeps the sort stable.
+        if (right == n || (left < half && compFunc(data[left], data[right]) <= 0))
+        {
+            buffer[i] = data[left++];
+        }
+        else
+        {
+            buffer[i] = data[right++];
+        }
+    }
+    memcpy(data, buffer, sizeof(void *) * (size_t)n);
+}
+
+/**
+ * sorts a part of the items, the first half on a new thread and the second on this one until the depth of
+ * the task runs out, then the halves are merged.
+ * @param arg the sort task.
+ * @return NULL.
+ */
+static void *sortWorker(void *arg)
+{
+    SortTask *task = (SortTask *)arg;
+    if (task->depth == 0 || task->n < PARALLEL_SORT_MIN)
+    {
+        mergeSort(task->data, task->buffer, task->n, task->compFunc);
+        return NULL;
+    }
+    int half = task->n / 2;
+    SortTask first = {task->data, task->buffer, half, task->depth - 1, task->compFunc};
+    SortTask second = {task->data + half, task->buffer + half, task->n - half, task->depth - 1, task->compFunc};
+    pthread_t worker;
+    int started = pthread_create(&worker, NULL, sortWorker, &first) == 0;
+    if (!started)
+    {
+        sortWorker(&first);
+    }
+    sortWorker(&second);
+    if (started)
+    {
+        pthread_join(worker, NULL);
+    }
+    int left = 0;
+    int right = half;
+    for (int i = 0; i < task->n; ++i)
+    {
+        if (right == task->n || (left < half && task->compFunc(task->data[left], task->data[right]) <= 0))
+        {
+            task->buffer[i] = task->data[left++];
+        }
+        else
+        {
+            task->buffer[i] = task->data[right++];
+        }
+    }
+    memcpy(task->data, task->buffer, sizeof(void *) * (size_t)task->n);
+    return NULL;
+}
+
+/**
+ * a function that builds a balanced subtree from sorted items, the middle item is the root of the subtree.
+ * in such a tree all the missing children are on the last two levels, so the nodes on the deepest level are
+ * red when that level is not full and all the others are black.
+ * @param tree the tree.
+ * @param data the sorted items.
+ * @param n the number of items.
+ * @param depth the depth of the root of the subtree.
+ * @param redDepth the depth of the red nodes, -1 for none.
+ * @param parent the parent of the subtree.
+ * @param failed holds 1 once a node couldn't be allocated, the building stops then.
+ * @return the root of the subtree, NULL if it is empty or there is no memory.
+ */
+static Node *buildSubtree(RBTree *tree, void **data, int n, int depth, int redDepth, Node *parent, int *failed)
+{
+    if (n == 0 || *failed)
+    {
+        return NULL;
+    }
+    Node *node = allocNode(tree);
+    if (node == NULL)
+    {
+        *failed = 1;
+        return NULL;
+    }
+    int middle = n / 2;
+    initNode(data[middle], node);
+    node->parent = parent;
+    node->color = (depth == redDepth) ? RED : BLACK;
+    if (hasSizes(tree))
+    {
+        ((TreeNode *)node)->subtreeSize = n;
+    }
+    node->left = buildSubtree(tree, data, middle, depth + 1, redDepth, node, failed);
+    node->right = buildSubtree(tree, data + middle + 1, n - middle - 1, depth + 1, redDepth, node, failed);
+    return node;
+}
+
+/**
+ * constructs a new RBTree from the given items in O(n) after they are sorted. the items are sorted by a
+ * parallel merge sort unless they are already in order, and of equal items only the first is kept, the
+ * others are freed with the freeFunc. the nodes of the tree are taken from a slab.
+ * @param data the items, the array itself is not changed.
+ * @param n the number of items.
+ * @param compFunc a function two compare two variables.
+ * @param freeFunc a function to free a variable.
+ * @return the tree, NULL if there is no memory (and then no item was freed).
+ */
+RBTree *buildRBTreeFromArray(void *data[], int n, CompareFunc compFunc, FreeFunc freeFunc)
+{
+    if (n < 0)
+    {
+        return NULL;
+    }
+    RBTree *tree = newRBTreeWithOptions(compFunc, freeFunc, RBTREE_SLAB_NODES);
+    void **items = (void **)malloc(2 * sizeof(void *) * (size_t)(n + 1));
+    if (tree == NULL || items == NULL)
+    {
+        free(items);
+        if (tree != NULL)
+        {
+            freeRBTree(tree);
+        }
+        return NULL;
+    }
+    void **buffer = items + n + 1;
+    memcpy(items, data, sizeof(void *) * (size_t)n);
+    int isSorted = 1;
+    for (int i = 1; i < n && isSorted; ++i)
+    {
+        isSorted = compFunc(items[i - 1], items[i]) <= 0;
+    }
+    if (!isSorted)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        int depth = 0;
+        while (depth < MAX_SORT_DEPTH && (1L << (depth + 1)) <= cores)
+        {
+            depth++;
+        }
+        SortTask task = {items, buffer, n, depth, compFunc};
+        sortWorker(&task);
+    }
+    // the equal items are next to each other, the duplicates are kept in the buffer until the tree is built.
+    int unique = 0;
+    int numOfDuplicates = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (unique > 0 && compFunc(items[unique - 1], items[i]) == 0)
+        {
+            buffer[numOfDuplicates++] = items[i];
+        }
+        else
+        {
+            items[unique++] = items[i];
+        }
+    }
+    int redDepth = -1;
+    if (((unique + 1) & unique) != 0)
+    {
+        // the deepest level is not full, its depth is floor(log2(unique)).
+        redDepth = 0;
+        while ((2 << redDepth) <= unique)
+        {
+            redDepth++;
+        }
+    }
+    int failed = 0;
+    tree->root = buildSubtree(tree, items, unique, 0, redDepth, NULL, &failed);
+    if (failed)
+    {
+        // the nodes go away with their blocks, and the items stay with the caller.
+        tree->root = NULL;
+        free(items);
+        freeRBTree(tree);
+        return NULL;
+    }
+    tree->size = unique;
+    for (int i = 0; i < numOfDuplicates; ++i)
+    {
+        freeFunc(buffer[i]);
+    }
+    free(items);
+    return tree;
+}
+
+/**
+ * a function that finds the first node that is not before the given data, or after it if strict.
+ * @param tree the tree.
+ * @param data the data to compare.
+ * @param strict 1 to find the first node after the data and 0 for the first node not before it.
+ * @return the node, NULL if there is none.
+ */
+static Node *findBound(RBTree *tree, void *data, int strict)
+{
+    Node *curr = tree->root;
+    Node *bound = NULL;
+    while (curr != NULL)
+    {
+        int comparison = tree->compFunc(data, curr->data);
+        if (comparison < 0 || (comparison == 0 && !strict))
+        {
+            bound = curr;
+            curr = curr->left;
+        }
+        else
+        {
+            curr = curr->right;
+        }
+    }
+    return bound;
+}
+
+/**
+ * find the first item of the tree that is not smaller than the given data.
+ * @param tree: the tree.
+ * @param data: the data to compare.
+ * @return: the item, NULL if all the items are smaller or the tree is a B+-tree.
+ */
+void *lowerBoundRBTree(RBTree *tree, void *data)
+{
+    if (isBTree(tree))
+    {
+        return NULL;
+    }
+    Node *bound = findBound(tree, data, 0);
+    return (bound == NULL) ? NULL : bound->data;
+}
+
+/**
+ * find the first item of the tree that is larger than the given data.
+ * @param tree: the tree.
+ * @param data: the data to compare.
+ * @return: the item, NULL if no item is larger or the tree is a B+-tree.
+ */
+void *upperBoundRBTree(RBTree *tree, void *data)
+{
+    if (isBTree(tree))
+    {
+        return NULL;
+    }
+    Node *bound = findBound(tree, data, 1);
+    return (bound == NULL) ? NULL : bound->data;
+}
+
+/**
+ * Activate a function on each item of the tree between low and high (both included), in an ascending order.
+ * if one of the activations of the function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param low: the data the items start from.
+ * @param high: the data the items end at.
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure (and always for a B+-tree), other on success.
+ */
+int forEachInRangeRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args)
+{
+    if (isBTree(tree))
+    {
+        return 0;
+    }
+    for (Node *curr = findBound(tree, low, 0); curr != NULL && tree->compFunc(curr->data, high) <= 0;
+         curr = returnNodesInOrder(curr))
+    {
+        if (!func(curr->data, args))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * count the items of the tree that are smaller than the given data, in O(log n) when the tree keeps order
+ * statistics and by a walk in order otherwise.
+ * @param tree: the tree.
+ * @param data: the data to compare, which doesn't have to be in the tree.
+ * @return: the rank of the data, the number of smaller items, -1 if the tree is a B+-tree.
+ */
+int rankOfRBTree(RBTree *tree, void *data)
+{
+    if (isBTree(tree))
+    {
+        return -1;
+    }
+    int rank = 0;
+    if (!hasSizes(tree))
+    {
+        for (Node *curr = (tree->root == NULL) ? NULL : findLeaf(tree->root);
+             curr != NULL && tree->compFunc(curr->data, data) < 0; curr = returnNodesInOrder(curr))
+        {
+            rank++;
+        }
+        return rank;
+    }
+    Node *curr = tree->root;
+    while (curr != NULL)
+    {
+        if (tree->compFunc(data, curr->data) <= 0)
+        {
+            curr = curr->left;
+        }
+        else
+        {
+            rank += subtreeSize(curr->left) + 1;
+            curr = curr->right;
+        }
+    }
+    return rank;
+}
+
+/**
+ * find the k-th smallest item of the tree, in O(log n) when the tree keeps order statistics and by a walk in
+ * order otherwise.
+ * @param tree: the tree.
+ * @param k: the rank of the item, from 0.
+ * @return: the item, NULL if k is not smaller than the size of the tree or the tree is a B+-tree.
+ */
+void *selectKthRBTree(RBTree *tree, int k)
+{
+    // the size is not negative, whatever its type.
+    if (k < 0 || (size_t)k >= (size_t)tree->size || isBTree(tree))
+    {
+        return NULL;
+    }
+    Node *curr;
+    if (!hasSizes(tree))
+    {
+        curr = findLeaf(tree->root);
+        for (int i = 0; i < k; ++i)
+        {
+            curr = returnNodesInOrder(curr);
+        }
+        return curr->data;
+    }
+    curr = tree->root;
+    while (subtreeSize(curr->left) != k)
+    {
+        if (k < subtreeSize(curr->left))
+        {
+            curr = curr->left;
+        }
+        else
+        {
+            k -= subtreeSize(curr->left) + 1;
+            curr = curr->right;
+        }
+    }
+    return curr->data;
+}
@@ -0,0 +1,527 @@
+#ifndef RBTREE_HPP
+#define RBTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+extern "C"
+{
+#include "Structs.h"
+}
+
+/**
+ * a red black tree of keys that are kept by value in its nodes, with the comparison inlined by the compiler.
+ * it runs the algorithms of RBTree.c, and needs C++17.
+ */
+namespace rbtree
+{
+    /**
+     * the comparison of two keys, that returns a number lower than 0, 0 or greater than 0 like a CompareFunc.
+     * there are specializations for int64_t, double, std::string_view and Vector, other keys are compared by <.
+     */
+    template <typename Key>
+    struct Compare
+    {
+        int operator()(const Key &a, const Key &b) const
+        {
+            return (b < a) - (a < b);
+        }
+    };
+
+    template <>
+    struct Compare<int64_t>
+    {
+        int operator()(int64_t a, int64_t b) const
+        {
+            return (a > b) - (a < b);
+        }
+    };
+
+    template <>
+    struct Compare<double>
+    {
+        int operator()(double a, double b) const
+        {
+            return (a > b) - (a < b);
+        }
+    };
+
+    /**
+     * compares strings in the lexicographic order of stringCompare.
+     */
+    template <>
+    struct Compare<std::string_view>
+    {
+        int operator()(std::string_view a, std::string_view b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    /**
+     * compares vectors element by element like vectorCompare1By1, a shorter vector that is equal to the start
+     * of a longer one is smaller. the tree keeps the Vector itself, not a copy of its elements.
+     */
+    template <>
+    struct Compare<Vector>
+    {
+        int operator()(const Vector &a, const Vector &b) const
+        {
+            int smallerLen = (a.len < b.len) ? a.len : b.len;
+            for (int i = 0; i < smallerLen; ++i)
+            {
+                if (a.vector[i] != b.vector[i])
+                {
+                    return (a.vector[i] > b.vector[i]) ? 1 : -1;
+                }
+            }
+            return (a.len > b.len) - (a.len < b.len);
+        }
+    };
+
+    /**
+     * a red black tree of distinct keys.
+     * @tparam Key the type of the keys, kept by value in the nodes.
+     * @tparam Comp the comparison of the keys, see Compare.
+     * @tparam Alloc the allocator of the keys, the nodes are allocated by its rebind.
+     */
+    template <typename Key, typename Comp = Compare<Key>, typename Alloc = std::allocator<Key>>
+    class RBTree
+    {
+    public:
+        /**
+         * constructs an empty tree.
+         * @param comp the comparison of the keys.
+         * @param alloc the allocator.
+         */
+        explicit RBTree(const Comp &comp = Comp(), const Alloc &alloc = Alloc())
+            : root(nullptr), count(0), compare(comp), nodeAlloc(alloc)
+        {
+        }
+
+        RBTree(const RBTree &) = delete;
+
+        RBTree &operator=(const RBTree &) = delete;
+
+        /**
+         * destroys the tree and all its keys.
+         */
+        ~RBTree()
+        {
+            freeNodes(root);
+        }
+
+        /**
+         * add a key to the tree, in a single descent with one comparison on every level.
+         * @param key the key.
+         * @return true if the key was added, false if it is already in the tree.
+         */
+        bool add(Key key)
+        {
+            Node *parent = nullptr;
+            int comparison = 0;
+            for (Node *curr = root; curr != nullptr; curr = (comparison < 0) ? curr->left : curr->right)
+            {
+                comparison = compare(key, curr->key);
+                if (comparison == 0)
+                {
+                    return false;
+                }
+                parent = curr;
+            }
+            Node *newNode = NodeTraits::allocate(nodeAlloc, 1);
+            try
+            {
+                NodeTraits::construct(nodeAlloc, newNode, std::move(key), parent);
+            }
+            catch (...)
+            {
+                NodeTraits::deallocate(nodeAlloc, newNode, 1);
+                throw;
+            }
+            replaceChild(parent, nullptr, newNode, comparison < 0);
+            fixTree(newNode);
+            count++;
+            return true;
+        }
+
+        /**
+         * check whether the tree contains this key.
+         * @param key the key.
+         * @return true if it does and false otherwise.
+         */
+        bool contains(const Key &key) const
+        {
+            return findNode(key) != nullptr;
+        }
+
+        /**
+         * delete a key from the tree.
+         * @param key a key equal to the key to delete.
+         * @return true if the key was deleted, false if it is not in the tree.
+         */
+        bool remove(const Key &key)
+        {
+            Node *node = findNode(key);
+            if (node == nullptr)
+            {
+                return false;
+            }
+            Node *child;
+            Node *parent;
+            Color removedColor = node->color;
+            if (node->left == nullptr || node->right == nullptr)
+            {
+                child = (node->left != nullptr) ? node->left : node->right;
+                parent = node->parent;
+                replaceChild(parent, node, child, false);
+            }
+            else
+            {
+                // the next node takes the place of the node, and its own place is the one that is removed.
+                Node *next = findLeaf(node->right);
+                removedColor = next->color;
+                child = next->right;
+                parent = next;
+                if (next->parent != node)
+                {
+                    parent = next->parent;
+                    replaceChild(next->parent, next, next->right, false);
+                    next->right = node->right;
+                    next->right->parent = next;
+                }
+                replaceChild(node->parent, node, next, false);
+                next->left = node->left;
+                next->left->parent = next;
+                next->color = node->color;
+            }
+            if (removedColor == BLACK)
+            {
+                fixDelete(child, parent);
+            }
+            NodeTraits::destroy(nodeAlloc, node);
+            NodeTraits::deallocate(nodeAlloc, node, 1);
+            count--;
+            return true;
+        }
+
+        /**
+         * activate a function on each key of the tree, in an ascending order. as in forEachRBTree, if one of the
+         * activations of the function returns a value that converts to false, the process stops.
+         * @param func the function, called with a const reference to every key. it may also return void.
+         * @return false if the tree is empty or an activation returned false, and true otherwise.
+         */
+        template <typename Func>
+        bool forEach(Func &&func) const
+        {
+            if (count == 0)
+            {
+                return false;
+            }
+            for (const Node *curr = findLeaf(root); curr != nullptr; curr = nextInOrder(curr))
+            {
+                if constexpr (std::is_void_v<std::invoke_result_t<Func &, const Key &>>)
+                {
+                    func(curr->key);
+                }
+                else if (!func(curr->key))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @return the number of keys in the tree.
+         */
+        std::size_t size() const
+        {
+            return count;
+        }
+
+    private:
+        /**
+         * a node of the tree, with its key inside it.
+         */
+        struct Node
+        {
+            Node *parent;
+            Node *left;
+            Node *right;
+            Color color;
+            Key key;
+
+            Node(Key &&newKey, Node *parentNode)
+                : parent(parentNode), left(nullptr), right(nullptr), color(RED), key(std::move(newKey))
+            {
+            }
+        };
+
+        using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+        Node *root;
+        std::size_t count;
+        Comp compare;
+        NodeAlloc nodeAlloc;
+
+        /**
+         * a function that finds the node of the given key.
+         * @param key the key.
+         * @return the node, nullptr if the key is not in the tree.
+         */
+        Node *findNode(const Key &key) const
+        {
+            Node *curr = root;
+            while (curr != nullptr)
+            {
+                int comparison = compare(key, curr->key);
+                if (comparison == 0)
+                {
+                    return curr;
+                }
+                curr = (comparison < 0) ? curr->left : curr->right;
+            }
+            return nullptr;
+        }
+
+        /**
+         * a function that finds the leftmost node under the given node.
+         * @param node a node.
+         * @return the leftmost node.
+         */
+        static Node *findLeaf(Node *node)
+        {
+            while (node->left != nullptr)
+            {
+                node = node->left;
+            }
+            return node;
+        }
+
+        /**
+         * a function that returns the next node in order, as returnNodesInOrder.
+         * @param node a node.
+         * @return the next node, nullptr after the last one.
+         */
+        static const Node *nextInOrder(const Node *node)
+        {
+            if (node->right != nullptr)
+            {
+                return findLeaf(node->right);
+            }
+            const Node *p = node->parent;
+            while (p != nullptr && node == p->right)
+            {
+                node = p;
+                p = p->parent;
+            }
+            return p;
+        }
+
+        /**
+         * a function that checks the color of a node, the missing children of a node are black.
+         * @param node a node or nullptr.
+         * @return true if the node is black.
+         */
+        static bool isBlack(const Node *node)
+        {
+            return node == nullptr || node->color == BLACK;
+        }
+
+        /**
+         * a function that puts a node (or nullptr) in the place of a child of the given parent.
+         * @param parent the parent, nullptr for the root.
+         * @param oldNode the child to replace, nullptr for a new child.
+         * @param newNode the node to put in its place.
+         * @param isLeft for a new child, true if it goes to the left.
+         */
+        void replaceChild(Node *parent, Node *oldNode, Node *newNode, bool isLeft)
+        {
+            if (parent == nullptr)
+            {
+                root = newNode;
+            }
+            else if ((oldNode == nullptr) ? isLeft : parent->left == oldNode)
+            {
+                parent->left = newNode;
+            }
+            else
+            {
+                parent->right = newNode;
+            }
+            if (newNode != nullptr)
+            {
+                newNode->parent = parent;
+            }
+        }
+
+        /**
+         * a function that rotates the tree left around the given node.
+         * @param node the node, which has a right child.
+         */
+        void rotateLeft(Node *node)
+        {
+            Node *temp = node->right;
+            node->right = temp->left;
+            if (node->right != nullptr)
+            {
+                node->right->parent = node;
+            }
+            replaceChild(node->parent, node, temp, false);
+            temp->left = node;
+            node->parent = temp;
+        }
+
+        /**
+         * a function that rotates the tree right around the given node.
+         * @param node the node, which has a left child.
+         */
+        void rotateRight(Node *node)
+        {
+            Node *temp = node->left;
+            node->left = temp->right;
+            if (node->left != nullptr)
+            {
+                node->left->parent = node;
+            }
+            replaceChild(node->parent, node, temp, false);
+            temp->right = node;
+            node->parent = temp;
+        }
+
+        /**
+         * a function that fixes the tree after a node was added, by the cases of fixTree.
+         * @param node the new node.
+         */
+        void fixTree(Node *node)
+        {
+            while (node->parent != nullptr && node->parent->color == RED)
+            {
+                Node *parent = node->parent;
+                Node *grandparent = parent->parent;
+                Node *uncle = (parent == grandparent->left) ? grandparent->right : grandparent->left;
+                if (!isBlack(uncle))
+                {
+                    parent->color = BLACK;
+                    uncle->color = BLACK;
+                    grandparent->color = RED;
+                    node = grandparent;
+                    continue;
+                }
+                if (node == parent->left && parent == grandparent->right)
+                {
+                    rotateRight(parent);
+                    node = parent;
+                    parent = node->parent;
+                }
+                else if (node == parent->right && parent == grandparent->left)
+                {
+                    rotateLeft(parent);
+                    node = parent;
+                    parent = node->parent;
+                }
+                if (node == parent->left)
+                {
+                    rotateRight(grandparent);
+                }
+                else
+                {
+                    rotateLeft(grandparent);
+                }
+                parent->color = BLACK;
+                grandparent->color = RED;
+            }
+            root->color = BLACK;
+        }
+
+        /**
+         * a function that fixes the tree after a black node was removed, as fixDelete.
+         * @param node the node that took the place of the removed node, may be nullptr.
+         * @param parent the parent of that place.
+         */
+        void fixDelete(Node *node, Node *parent)
+        {
+            while (node != root && isBlack(node))
+            {
+                bool isLeft = node == parent->left;
+                Node *sibling = isLeft ? parent->right : parent->left;
+                if (sibling->color == RED)
+                {
+                    sibling->color = BLACK;
+                    parent->color = RED;
+                    if (isLeft)
+                    {
+                        rotateLeft(parent);
+                    }
+                    else
+                    {
+                        rotateRight(parent);
+                    }
+                    sibling = isLeft ? parent->right : parent->left;
+                }
+                if (isBlack(sibling->left) && isBlack(sibling->right))
+                {
+                    sibling->color = RED;
+                    node = parent;
+                    parent = node->parent;
+                    continue;
+                }
+                if (isLeft && isBlack(sibling->right))
+                {
+                    sibling->left->color = BLACK;
+                    sibling->color = RED;
+                    rotateRight(sibling);
+                    sibling = parent->right;
+                }
+                else if (!isLeft && isBlack(sibling->left))
+                {
+                    sibling->right->color = BLACK;
+                    sibling->color = RED;
+                    rotateLeft(sibling);
+                    sibling = parent->left;
+                }
+                sibling->color = parent->color;
+                parent->color = BLACK;
+                if (isLeft)
+                {
+                    sibling->right->color = BLACK;
+                    rotateLeft(parent);
+                }
+                else
+                {
+                    sibling->left->color = BLACK;
+                    rotateRight(parent);
+                }
+                node = root;
+            }
+            if (node != nullptr)
+            {
+                node->color = BLACK;
+            }
+        }
+
+        /**
+         * a function that frees the nodes under the given node.
+         * @param node a node or nullptr.
+         */
+        void freeNodes(Node *node)
+        {
+            while (node != nullptr)
+            {
+                freeNodes(node->left);
+                Node *right = node->right;
+                NodeTraits::destroy(nodeAlloc, node);
+                NodeTraits::deallocate(nodeAlloc, node, 1);
+                node = right;
+            }
+        }
+    };
+}
+
+#endif
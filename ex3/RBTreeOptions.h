@@ -0,0 +1,28 @@
+/**
+ * the options of an RBTree and the functions that go beyond RBTree.h, see their documentation in RBTree.c.
+ */
+#ifndef RBTREE_OPTIONS_H
+#define RBTREE_OPTIONS_H
+
+#include "RBTree.h"
+
+/**
+ * the options of newRBTreeWithOptions, that may be or-ed.
+ */
+#define RBTREE_SLAB_NODES 1
+#define RBTREE_ORDER_STATISTICS 2
+#define RBTREE_CONCURRENT 4
+#define RBTREE_BTREE 8
+
+RBTree *newRBTreeWithOptions(CompareFunc compFunc, FreeFunc freeFunc, int options);
+void *insertOrFindRBTree(RBTree *tree, void *data, Node **hint);
+void *removeFromRBTree(RBTree *tree, void *data);
+int deleteFromRBTree(RBTree *tree, void *data);
+RBTree *buildRBTreeFromArray(void *data[], int n, CompareFunc compFunc, FreeFunc freeFunc);
+void *lowerBoundRBTree(RBTree *tree, void *data);
+void *upperBoundRBTree(RBTree *tree, void *data);
+int forEachInRangeRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args);
+int rankOfRBTree(RBTree *tree, void *data);
+void *selectKthRBTree(RBTree *tree, int k);
+
+#endif